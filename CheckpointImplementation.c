@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "CheckpointInterface.h"
+
+#define FNV_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+static uint64_t fnv1a(const void *data, size_t size)
+{
+  const unsigned char *p = (const unsigned char *) data;
+  uint64_t h = FNV_BASIS;
+  size_t   i;
+
+  for (i = 0; i < size; i++)
+  {
+    h ^= p[i];
+    h *= FNV_PRIME;
+  }
+  return h;
+}
+
+int ckpt_save(const char *name, const char *key, const void *state,
+              size_t size)
+{
+  CKPT_HEADER hdr;
+  char     *tmp;
+  int      fd;
+  int      ok;
+
+  memcpy(hdr.Magic, CKPT_MAGIC, sizeof(hdr.Magic));
+  hdr.Key = fnv1a(key, strlen(key));
+  hdr.Size = size;
+  hdr.Sum = fnv1a(state, size);
+
+  tmp = (char *) malloc(strlen(name) + 5);
+  if (tmp == NULL)
+    return -1;
+  sprintf(tmp, "%s.tmp", name);
+  fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+  {
+    fprintf(stderr, "ERROR in creating checkpoint file (%s) \n", tmp);
+    free(tmp);
+    return -1;
+  }
+  ok = (write(fd, &hdr, sizeof(hdr)) == (ssize_t) sizeof(hdr)) &&
+       (write(fd, state, size) == (ssize_t) size) && (fsync(fd) == 0);
+  ok = (close(fd) == 0) && ok;
+
+  // The old checkpoint stays in place until the new one is complete
+  if (!ok || (rename(tmp, name) != 0))
+  {
+    fprintf(stderr, "ERROR in writing checkpoint file (%s) \n", name);
+    unlink(tmp);
+    free(tmp);
+    return -1;
+  }
+  free(tmp);
+  return 0;
+}
+
+int ckpt_load(const char *name, const char *key, void *state, size_t size)
+{
+  const CKPT_HEADER *hdr;
+  struct stat st;
+  void     *map;
+  size_t   length;
+  int      fd;
+  int      result = 1;
+
+  fd = open(name, O_RDONLY);
+  if (fd < 0)
+    return 0;
+  if ((fstat(fd, &st) != 0) ||
+      ((size_t) st.st_size != sizeof(CKPT_HEADER) + size))
+  {
+    fprintf(stderr, "ERROR checkpoint file (%s) is not %lu bytes of state \n",
+      name, (unsigned long) size);
+    close(fd);
+    return -1;
+  }
+  length = (size_t) st.st_size;
+  map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+  {
+    fprintf(stderr, "ERROR in mapping checkpoint file (%s) \n", name);
+    return -1;
+  }
+
+  hdr = (const CKPT_HEADER *) map;
+  if ((memcmp(hdr->Magic, CKPT_MAGIC, sizeof(hdr->Magic)) != 0) ||
+      (hdr->Size != size) ||
+      (hdr->Sum != fnv1a((const char *) map + sizeof(CKPT_HEADER), size)))
+  {
+    fprintf(stderr, "ERROR checkpoint file (%s) is damaged \n", name);
+    result = -1;
+  }
+  else if (hdr->Key != fnv1a(key, strlen(key)))
+  {
+    fprintf(stderr, "ERROR checkpoint file (%s) is from another run \n", name);
+    result = -1;
+  }
+  else
+    memcpy(state, (const char *) map + sizeof(CKPT_HEADER), size);
+
+  munmap(map, length);
+  return result;
+}
+
+int ckpt_remove(const char *name)
+{
+  return unlink(name);
+}
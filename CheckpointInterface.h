@@ -0,0 +1,52 @@
+//============================================ file = CheckpointInterface.h ===
+//=  Checkpoints of a run's state in a compact binary file                    =
+//=============================================================================
+//=  Notes:                                                                   =
+//=   1) The state is a flat struct (no pointers) that the caller fills in    =
+//=      and copies back; ckpt_save() writes it behind a header (magic,       =
+//=      key hash, size, checksum) to name.tmp, syncs it and renames it       =
+//=      over name, so the file is always the old or the new checkpoint       =
+//=   2) ckpt_load() maps the file once and checks the header before it       =
+//=      copies the state out: a file from another configuration (key), a     =
+//=      state of another size or a damaged file is refused, never loaded     =
+//=   3) The key is a string that names everything the state depends on       =
+//=      (build, parameters, seed); only its hash is stored                   =
+//=   4) Only state the caller owns can be saved.  CSIM's event list and      =
+//=      processes live inside the library, so load_balancing_csim.c          =
+//=      checkpoints between replication groups only: a single long run       =
+//=      (RUN_LENGTH) cannot be checkpointed and rejects -c.  For a long      =
+//=      run that may be evicted, build with RUN_REPS and run with -c;        =
+//=      eviction then loses at most the group in progress                    =
+//=============================================================================
+#ifndef _CHECKPOINT_INTERFACE_H
+#define _CHECKPOINT_INTERFACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CKPT_MAGIC "CSIMCKP1"   // First 8 bytes of every checkpoint file
+
+#ifndef Ckpt_Header_Has_Been_Defined
+   typedef struct {
+     char     Magic[8];     // CKPT_MAGIC
+     uint64_t Key;          // FNV-1a hash of the key string
+     uint64_t Size;         // Bytes of state after the header
+     uint64_t Sum;          // FNV-1a hash of the state
+   } CKPT_HEADER;
+#define Ckpt_Header_Has_Been_Defined
+#endif
+
+// defined operations
+extern int ckpt_save(const char *name, const char *key, const void *state,
+                     size_t size);
+// Write state atomically to file name; 0 on success, -1 on error
+
+extern int ckpt_load(const char *name, const char *key, void *state,
+                     size_t size);
+// Restore state from file name: 1 if restored, 0 if there is no file,
+// -1 if the file does not match key and size or is damaged
+
+extern int ckpt_remove(const char *name);
+// Remove the checkpoint once the run has finished; 0 on success
+
+#endif
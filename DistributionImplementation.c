@@ -0,0 +1,620 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "DistributionInterface.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+//----- fdlibm constants for log() and exp() ----------------------------------
+#define LN2_HI  6.93147180369123816490e-01
+#define LN2_LO  1.90821492927058770002e-10
+#define INV_LN2 1.44269504088896338700e+00
+#define SQRT2   1.41421356237309514547e+00
+#define LG1 6.666666666666735130e-01
+#define LG2 3.999999999940941908e-01
+#define LG3 2.857142874366239149e-01
+#define LG4 2.222219843214978396e-01
+#define LG5 1.818357216161805012e-01
+#define LG6 1.531383769920937332e-01
+#define LG7 1.479819860511658591e-01
+#define EP1  1.66666666666666019037e-01
+#define EP2 -2.77777777770155933842e-03
+#define EP3  6.61375632143793436117e-05
+#define EP4 -1.65339022054652515390e-06
+#define EP5  4.13813679705723846039e-08
+
+
+//----- Ziggurat for the unit exponential (256 layers) ------------------------
+#define ZIG_R 7.69711747013104972           // Start of the tail
+#define ZIG_V 0.0039496598225815571993      // Area of each layer
+#define ZIG_CHUNK 256                       // Words drawn per pass in a refill
+#define ZIG_POOL 64                         // Spare words for the slow path
+#define TO_53(w) ((double)(int64_t)((w) >> 11) * (1.0 / 9007199254740992.0))
+#define TO_OPEN(w) (((double)(int64_t)((w) >> 12) + 0.5) * (1.0 / 4503599627370496.0))
+
+typedef struct {            // Words for the slow path, drawn in bulk too
+  uint64_t W[ZIG_POOL];
+  int      Next;
+} ZIG_SPARE;
+
+static double Zig_x[257];   // Layer i spans x in [0, Zig_x[i]], Zig_x[256] = 0
+static double Zig_f[257];   // exp(-Zig_x[i])
+static int    Zig_ready = 0;
+
+//=============================================================================
+//==  Scalar kernels: positive normal arguments only, no special cases       ==
+//=============================================================================
+static double kernel_log(double x)
+{
+  uint64_t bits;
+  double   k, m, f, s, z, w, t1, t2, r, hfsq;
+
+  // x = 2^k * m with m in [sqrt(2)/2, sqrt(2))
+  memcpy(&bits, &x, sizeof(bits));
+  k = (double)((int)(bits >> 52) - 1023);
+  bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+  memcpy(&m, &bits, sizeof(m));
+  if (m > SQRT2)
+  {
+    m = 0.5 * m;
+    k = k + 1.0;
+  }
+
+  f = m - 1.0;
+  s = f / (2.0 + f);
+  z = s * s;
+  w = z * z;
+  t1 = w * (LG2 + w * (LG4 + w * LG6));
+  t2 = z * (LG1 + w * (LG3 + w * (LG5 + w * LG7)));
+  r = t2 + t1;
+  hfsq = 0.5 * f * f;
+
+  return k * LN2_HI - ((hfsq - (s * (hfsq + r) + k * LN2_LO)) - f);
+}
+
+static double kernel_exp(double x)
+{
+  uint64_t bits;
+  double   k, hi, lo, r, t, c, y, scale;
+
+  // x = k*ln2 + r with |r| <= ln2/2
+  k = floor(x * INV_LN2 + 0.5);
+  hi = x - k * LN2_HI;
+  lo = k * LN2_LO;
+  r = hi - lo;
+
+  t = r * r;
+  c = r - t * (EP1 + t * (EP2 + t * (EP3 + t * (EP4 + t * EP5))));
+  y = 1.0 - ((lo - (r * c) / (2.0 - c)) - hi);
+
+  bits = (uint64_t)((int64_t)k + 1023) << 52;
+  memcpy(&scale, &bits, sizeof(scale));
+
+  return y * scale;
+}
+
+#ifdef __AVX2__
+//=============================================================================
+//==  AVX2 kernels: the scalar kernels above, four lanes at a time           ==
+//=============================================================================
+static __m256d kernel_log4(__m256d x)
+{
+  const __m256i mant = _mm256_set1_epi64x(0x000fffffffffffffLL);
+  const __m256i one = _mm256_set1_epi64x(0x3ff0000000000000LL);
+  const __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL);
+  const __m256d two52 = _mm256_set1_pd(4503599627370496.0);
+  __m256i bits = _mm256_castpd_si256(x);
+  __m256d k, m, big, f, s, z, w, t1, t2, r, hfsq;
+
+  // Exponent field to double via the 2^52 trick, then unbias
+  k = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), magic)), two52);
+  k = _mm256_sub_pd(k, _mm256_set1_pd(1023.0));
+  m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, mant), one));
+
+  big = _mm256_cmp_pd(m, _mm256_set1_pd(SQRT2), _CMP_GT_OQ);
+  m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), big);
+  k = _mm256_add_pd(k, _mm256_and_pd(big, _mm256_set1_pd(1.0)));
+
+  f = _mm256_sub_pd(m, _mm256_set1_pd(1.0));
+  s = _mm256_div_pd(f, _mm256_add_pd(_mm256_set1_pd(2.0), f));
+  z = _mm256_mul_pd(s, s);
+  w = _mm256_mul_pd(z, z);
+  t1 = _mm256_add_pd(_mm256_set1_pd(LG4), _mm256_mul_pd(w, _mm256_set1_pd(LG6)));
+  t1 = _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG2), _mm256_mul_pd(w, t1)));
+  t2 = _mm256_add_pd(_mm256_set1_pd(LG5), _mm256_mul_pd(w, _mm256_set1_pd(LG7)));
+  t2 = _mm256_add_pd(_mm256_set1_pd(LG3), _mm256_mul_pd(w, t2));
+  t2 = _mm256_mul_pd(z, _mm256_add_pd(_mm256_set1_pd(LG1), _mm256_mul_pd(w, t2)));
+  r = _mm256_add_pd(t2, t1);
+  hfsq = _mm256_mul_pd(_mm256_set1_pd(0.5), _mm256_mul_pd(f, f));
+
+  // k*ln2_hi - ((hfsq - (s*(hfsq + r) + k*ln2_lo)) - f)
+  r = _mm256_add_pd(_mm256_mul_pd(s, _mm256_add_pd(hfsq, r)),
+                    _mm256_mul_pd(k, _mm256_set1_pd(LN2_LO)));
+  r = _mm256_sub_pd(_mm256_sub_pd(hfsq, r), f);
+  return _mm256_sub_pd(_mm256_mul_pd(k, _mm256_set1_pd(LN2_HI)), r);
+}
+
+static __m256d kernel_exp4(__m256d x)
+{
+  const __m256d magic = _mm256_set1_pd(4503599627370496.0 + 1023.0);
+  __m256d k, hi, lo, r, t, c, y, scale;
+
+  k = _mm256_floor_pd(_mm256_add_pd(_mm256_mul_pd(x, _mm256_set1_pd(INV_LN2)),
+                                    _mm256_set1_pd(0.5)));
+  hi = _mm256_sub_pd(x, _mm256_mul_pd(k, _mm256_set1_pd(LN2_HI)));
+  lo = _mm256_mul_pd(k, _mm256_set1_pd(LN2_LO));
+  r = _mm256_sub_pd(hi, lo);
+
+  t = _mm256_mul_pd(r, r);
+  c = _mm256_add_pd(_mm256_set1_pd(EP4), _mm256_mul_pd(t, _mm256_set1_pd(EP5)));
+  c = _mm256_add_pd(_mm256_set1_pd(EP3), _mm256_mul_pd(t, c));
+  c = _mm256_add_pd(_mm256_set1_pd(EP2), _mm256_mul_pd(t, c));
+  c = _mm256_add_pd(_mm256_set1_pd(EP1), _mm256_mul_pd(t, c));
+  c = _mm256_sub_pd(r, _mm256_mul_pd(t, c));
+
+  // 1 - ((lo - (r*c)/(2 - c)) - hi)
+  y = _mm256_div_pd(_mm256_mul_pd(r, c), _mm256_sub_pd(_mm256_set1_pd(2.0), c));
+  y = _mm256_sub_pd(_mm256_set1_pd(1.0), _mm256_sub_pd(_mm256_sub_pd(lo, y), hi));
+
+  // 2^k: k + 1023 lands in the low mantissa bits of 2^52 + k + 1023
+  scale = _mm256_castsi256_pd(_mm256_slli_epi64(
+            _mm256_castpd_si256(_mm256_add_pd(k, magic)), 52));
+
+  return _mm256_mul_pd(y, scale);
+}
+#endif
+
+//=============================================================================
+//==  Function to set up a bounded Pareto distribution                       ==
+//=============================================================================
+void setup_bpareto(double a, double k, double p, BPAR_PARAMS *bp)
+{
+  bp->A = a;
+  bp->K = k;
+  bp->P = p;
+  bp->D = pow((k / p), a);
+  bp->NegInvA = -1.0 / a;
+}
+
+//=============================================================================
+//==  Function to generate one bounded Pareto rv by inversion                ==
+//=============================================================================
+double bpareto_rv(const BPAR_PARAMS *bp, double z)
+{
+  return bp->K * pow((1.0 - z) + z * bp->D, bp->NegInvA);
+}
+
+//=============================================================================
+//==  Function to transform an array of uniforms into bounded Pareto rvs     ==
+//=============================================================================
+void fill_bpareto(const BPAR_PARAMS *bp, const double *z, double *x, long n)
+{
+  long i = 0;
+
+#ifdef __AVX2__
+  const __m256d d = _mm256_set1_pd(bp->D);
+  const __m256d neg_inv_a = _mm256_set1_pd(bp->NegInvA);
+  const __m256d k = _mm256_set1_pd(bp->K);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const long    nv = n - n % 4;
+  __m256d w;
+
+  for (; i < nv; i += 4)
+  {
+    w = _mm256_loadu_pd(z + i);
+    w = _mm256_add_pd(_mm256_sub_pd(one, w), _mm256_mul_pd(w, d));
+    w = kernel_exp4(_mm256_mul_pd(neg_inv_a, kernel_log4(w)));
+    _mm256_storeu_pd(x + i, _mm256_mul_pd(k, w));
+  }
+#endif
+
+  for (; i < n; i++)
+    x[i] = bp->K * kernel_exp(bp->NegInvA * kernel_log((1.0 - z[i]) + z[i] * bp->D));
+}
+
+//=============================================================================
+//==  Function for the mean of a bounded Pareto                              ==
+//=============================================================================
+double bpareto_mean(const BPAR_PARAMS *bp)
+{
+  double a = bp->A;
+
+  if (a == 1.0)
+    return bp->K * log(bp->P / bp->K) / (1.0 - bp->D);
+  return a * bp->K * (1.0 - pow(bp->K / bp->P, a - 1.0)) /
+         ((a - 1.0) * (1.0 - bp->D));
+}
+
+//=============================================================================
+//==  Function to fill an array with bounded Pareto rvs from a stream        ==
+//=============================================================================
+void pstream_fill_bpareto(PSTREAM s, const BPAR_PARAMS *bp, double *x, long n)
+{
+  // Uniforms are generated in place, so x doubles as the scratch buffer
+  pstream_fill_uniform01(s, x, n);
+  fill_bpareto(bp, x, x, n);
+}
+
+//=============================================================================
+//==  Functions to set up the distribution objects                           ==
+//=============================================================================
+void setup_expo(double mean, EXPO_DIST *d)
+{
+  d->Mean = mean;
+}
+
+void setup_deter(double value, DETER_DIST *d)
+{
+  d->Value = value;
+}
+
+void setup_bpar_dist(double a, double k, double p, BPAR_DIST *d)
+{
+  setup_bpareto(a, k, p, &d->Par);
+  d->Next = DIST_BUF;
+}
+
+void refill_bpar_dist(BPAR_DIST *d, PSTREAM s)
+{
+  pstream_fill_bpareto(s, &d->Par, d->Buf, DIST_BUF);
+  d->Next = 0;
+}
+
+void setup_erlang(double mean, int k, ERLANG_DIST *d)
+{
+  d->Stages = k;
+  d->StageMean = mean / k;
+}
+
+void setup_hyperx(double mean, double var, HYPERX_DIST *d)
+{
+  double cv2 = var / (mean * mean);
+
+  if (cv2 <= 1.0)
+  {
+    fprintf(stderr, "hyperexponential needs var > mean^2, using exponential");
+    cv2 = 1.0;
+  }
+
+  // Balanced means: P1*Mean1 == P2*Mean2
+  d->P1 = 0.5 * (1.0 + sqrt((cv2 - 1.0) / (cv2 + 1.0)));
+  d->Mean1 = mean / (2.0 * d->P1);
+  d->Mean2 = mean / (2.0 * (1.0 - d->P1));
+}
+
+void setup_lognorm(double mean, double stddev, LOGNORM_DIST *d)
+{
+  double s2 = log(1.0 + (stddev * stddev) / (mean * mean));
+
+  d->Mu = log(mean) - 0.5 * s2;
+  d->Sigma = sqrt(s2);
+  d->HasSpare = 0;
+}
+
+//=============================================================================
+//==  Functions for empirical distributions (alias tables)                   ==
+//=============================================================================
+int build_empirical(const double *x, long n, int bins, EMP_DIST *d)
+{
+  double *bmin, *bmax, *prob;
+  long   *cnt;
+  int    *alias, *small, *large;
+  int    num_small = 0, num_large = 0;
+  int    logbin, i, j;
+  double mn, mx, sum = 0.0, lo, scale, v;
+  long   k;
+
+  if ((n < 1) || (bins < 1))
+  {
+    fprintf(stderr, "ERROR empirical table needs values and bins \n");
+    return -1;
+  }
+
+  mn = mx = x[0];
+  for (k = 0; k < n; k++)
+  {
+    if (!isfinite(x[k]) || (x[k] < 0.0))
+    {
+      fprintf(stderr, "ERROR empirical value %ld (%f) is not a time \n",
+        k, x[k]);
+      return -1;
+    }
+    if (x[k] < mn) mn = x[k];
+    if (x[k] > mx) mx = x[k];
+    sum += x[k];
+  }
+
+  // Log-spaced bins keep resolution in a heavy tail; zero forces linear
+  logbin = (mn > 0.0);
+  if (mx == mn)
+    bins = 1;
+  lo = logbin ? log(mn) : mn;
+  scale = (bins == 1) ? 0.0 : bins / ((logbin ? log(mx) : mx) - lo);
+
+  bmin = (double *)malloc(bins * sizeof(double));
+  bmax = (double *)malloc(bins * sizeof(double));
+  prob = (double *)malloc(bins * sizeof(double));
+  cnt = (long *)calloc(bins, sizeof(long));
+  alias = (int *)malloc(bins * sizeof(int));
+  small = (int *)malloc(bins * sizeof(int));
+  large = (int *)malloc(bins * sizeof(int));
+  d->Bin = (EMP_BIN *)malloc(bins * sizeof(EMP_BIN));
+  if (!bmin || !bmax || !prob || !cnt || !alias || !small || !large || !d->Bin)
+  {
+    fprintf(stderr, "ERROR out of memory for empirical table \n");
+    free(bmin);  free(bmax);  free(prob);  free(cnt);
+    free(alias);  free(small);  free(large);  free(d->Bin);
+    d->Bin = NULL;
+    return -1;
+  }
+
+  // Count each bin and track the range of values actually in it
+  for (j = 0; j < bins; j++)
+  {
+    bmin[j] = mx;
+    bmax[j] = mn;
+  }
+  for (k = 0; k < n; k++)
+  {
+    j = (int)(((logbin ? log(x[k]) : x[k]) - lo) * scale);
+    if (j >= bins) j = bins - 1;
+    if (j < 0) j = 0;
+    cnt[j]++;
+    if (x[k] < bmin[j]) bmin[j] = x[k];
+    if (x[k] > bmax[j]) bmax[j] = x[k];
+  }
+
+  // Vose's alias method: pair each under-full bin with an over-full one
+  for (j = 0; j < bins; j++)
+  {
+    prob[j] = (double)cnt[j] * bins / n;
+    alias[j] = j;
+    if (prob[j] < 1.0)
+      small[num_small++] = j;
+    else
+      large[num_large++] = j;
+  }
+  while ((num_small > 0) && (num_large > 0))
+  {
+    i = small[--num_small];
+    j = large[--num_large];
+    alias[i] = j;
+    prob[j] = (prob[j] + prob[i]) - 1.0;
+    if (prob[j] < 1.0)
+      small[num_small++] = j;
+    else
+      large[num_large++] = j;
+  }
+
+  // Whatever is left is full up to rounding
+  while (num_small > 0)
+    prob[small[--num_small]] = 1.0;
+  while (num_large > 0)
+    prob[large[--num_large]] = 1.0;
+
+  for (j = 0; j < bins; j++)
+  {
+    if (cnt[j] == 0)
+      bmin[j] = bmax[j] = 0.0;
+  }
+  for (j = 0; j < bins; j++)
+  {
+    i = alias[j];
+    v = bmax[j] - bmin[j];
+    d->Bin[j].Cut = prob[j];
+    d->Bin[j].Lo = bmin[j];
+    d->Bin[j].Scale = (prob[j] > 0.0) ? v / prob[j] : 0.0;
+    d->Bin[j].AliasLo = bmin[i];
+    d->Bin[j].AliasScale =
+      (prob[j] < 1.0) ? (bmax[i] - bmin[i]) / (1.0 - prob[j]) : 0.0;
+  }
+  d->Bins = bins;
+  d->Mean = sum / n;
+  d->Count = n;
+  d->Next = DIST_BUF;
+
+  free(bmin);  free(bmax);  free(prob);  free(cnt);
+  free(alias);  free(small);  free(large);
+
+  return 0;
+}
+
+int save_empirical(const char *name, const EMP_DIST *d)
+{
+  FILE    *fp;
+  int32_t bins = d->Bins;
+  int64_t count = d->Count;
+  int     ok;
+
+  fp = fopen(name, "wb");
+  if (fp == NULL)
+  {
+    fprintf(stderr, "ERROR in creating empirical table (%s) \n", name);
+    return -1;
+  }
+  ok = (fwrite(EMP_MAGIC, 8, 1, fp) == 1) &&
+       (fwrite(&bins, sizeof(bins), 1, fp) == 1) &&
+       (fwrite(&count, sizeof(count), 1, fp) == 1) &&
+       (fwrite(&d->Mean, sizeof(double), 1, fp) == 1) &&
+       (fwrite(d->Bin, sizeof(EMP_BIN), bins, fp) == (size_t)bins);
+  if ((fclose(fp) != 0) || !ok)
+  {
+    fprintf(stderr, "ERROR in writing empirical table (%s) \n", name);
+    return -1;
+  }
+
+  return 0;
+}
+
+int load_empirical(const char *name, EMP_DIST *d)
+{
+  FILE    *fp;
+  char    magic[8];
+  int32_t bins;
+  int64_t count;
+  int     ok;
+
+  fp = fopen(name, "rb");
+  if (fp == NULL)
+  {
+    fprintf(stderr, "ERROR in opening empirical table (%s) \n", name);
+    return -1;
+  }
+  d->Next = DIST_BUF;
+  ok = (fread(magic, 8, 1, fp) == 1) &&
+       (memcmp(magic, EMP_MAGIC, 8) == 0) &&
+       (fread(&bins, sizeof(bins), 1, fp) == 1) && (bins > 0) &&
+       (fread(&count, sizeof(count), 1, fp) == 1) &&
+       (fread(&d->Mean, sizeof(double), 1, fp) == 1);
+  d->Bin = NULL;
+  if (ok)
+  {
+    d->Bins = bins;
+    d->Count = (long)count;
+    d->Bin = (EMP_BIN *)malloc(bins * sizeof(EMP_BIN));
+    ok = (d->Bin != NULL) &&
+         (fread(d->Bin, sizeof(EMP_BIN), bins, fp) == (size_t)bins);
+  }
+  fclose(fp);
+  if (!ok)
+  {
+    fprintf(stderr, "ERROR empirical table (%s) is not valid \n", name);
+    free(d->Bin);
+    d->Bin = NULL;
+    return -1;
+  }
+
+  return 0;
+}
+
+void refill_empirical(EMP_DIST *d, PSTREAM s)
+{
+  int i;
+
+  pstream_fill_uniform01(s, d->Buf, DIST_BUF);
+  for (i = 0; i < DIST_BUF; i++)
+    d->Buf[i] = emp_value(d, d->Buf[i]);
+  d->Next = 0;
+}
+
+void free_empirical(EMP_DIST *d)
+{
+  free(d->Bin);
+  d->Bin = NULL;
+  d->Bins = 0;
+}
+
+double emp_mean(const EMP_DIST *d)
+{
+  const EMP_BIN *b;
+  double        sum = 0.0;
+  double        c;
+  int           i;
+
+  // Each slot is uniform on [Lo, Lo + Cut*Scale) with probability Cut and
+  // on [AliasLo, AliasLo + (1 - Cut)*AliasScale) otherwise
+  for (i = 0; i < d->Bins; i++)
+  {
+    b = &d->Bin[i];
+    c = b->Cut;
+    sum += c * (b->Lo + 0.5 * c * b->Scale) +
+           (1.0 - c) * (b->AliasLo + 0.5 * (1.0 - c) * b->AliasScale);
+  }
+  return sum / d->Bins;
+}
+
+//=============================================================================
+//==  Function to build the ziggurat layers (once per process)               ==
+//=============================================================================
+static void setup_ziggurat(void)
+{
+  int i;
+
+  if (Zig_ready)
+    return;
+
+  // Layer 0 is the base rectangle plus the tail, folded into one width
+  Zig_x[0] = ZIG_V / exp(-ZIG_R);
+  Zig_x[1] = ZIG_R;
+  for (i = 1; i < 255; i++)
+    Zig_x[i + 1] = -log(ZIG_V / Zig_x[i] + exp(-Zig_x[i]));
+  Zig_x[256] = 0.0;
+  for (i = 0; i < 257; i++)
+    Zig_f[i] = exp(-Zig_x[i]);
+
+  Zig_ready = 1;
+}
+
+static uint64_t zig_word(ZIG_SPARE *sp, PSTREAM s)
+{
+  if (sp->Next == ZIG_POOL)
+  {
+    pstream_fill64(s, sp->W, ZIG_POOL);
+    sp->Next = 0;
+  }
+  return sp->W[sp->Next++];
+}
+
+//=============================================================================
+//==  Function for the ziggurat slow path (tail, wedges and retries)         ==
+//=============================================================================
+static double zig_slow(ZIG_SPARE *sp, PSTREAM s, int i, double x)
+{
+  uint64_t w;
+
+  while (1)
+  {
+    // Tail beyond R is R plus a fresh exponential (memoryless)
+    if (i == 0)
+      return ZIG_R - log(TO_OPEN(zig_word(sp, s)));
+
+    // Wedge between the rectangle edge and the curve
+    if (Zig_f[i] + TO_53(zig_word(sp, s)) * (Zig_f[i + 1] - Zig_f[i]) < exp(-x))
+      return x;
+
+    // Rejected, so start over with a new layer and point
+    w = zig_word(sp, s);
+    i = (int)(w & 0xff);
+    x = TO_53(w) * Zig_x[i];
+    if (x < Zig_x[i + 1])
+      return x;
+  }
+}
+
+void setup_zig_expo(double mean, ZIG_EXPO_DIST *d)
+{
+  setup_ziggurat();
+  d->Mean = mean;
+  d->Next = ZIG_BUF;
+}
+
+void refill_zig_expo(ZIG_EXPO_DIST *d, PSTREAM s)
+{
+  uint64_t  w[ZIG_CHUNK];
+  ZIG_SPARE spare;
+  double    *x;
+  long      base;
+  int       j;
+
+  spare.Next = ZIG_POOL;
+  for (base = 0; base < ZIG_BUF; base += ZIG_CHUNK)
+  {
+    x = d->Buf + base;
+
+    // Fast path for every slot: layer from the low byte, point from the top
+    pstream_fill64(s, w, ZIG_CHUNK);
+    for (j = 0; j < ZIG_CHUNK; j++)
+      x[j] = TO_53(w[j]) * Zig_x[w[j] & 0xff];
+
+    // Redraw the few that fell outside their layer's inner rectangle
+    for (j = 0; j < ZIG_CHUNK; j++)
+    {
+      if (x[j] >= Zig_x[(w[j] & 0xff) + 1])
+        x[j] = zig_slow(&spare, s, (int)(w[j] & 0xff), x[j]);
+    }
+  }
+  d->Next = 0;
+}
@@ -0,0 +1,279 @@
+//========================================== file = DistributionInterface.h ===
+//=  Service and interarrival time distributions for the CSIM models          =
+//=============================================================================
+//=  Notes:                                                                   =
+//=   1) Uniforms come from a PSTREAM (StreamInterface.h)                     =
+//=   2) Bounded Pareto uses the inversion from genpar2.c rewritten as        =
+//=      x = k * ((1 - z) + z*(k/p)^a)^(-1/a); the constants are computed     =
+//=      once by setup_bpareto() and 1 - z is exact for z near 1, where the   =
+//=      original expression cancels                                          =
+//=   3) fill_bpareto() evaluates log/exp with fdlibm polynomials, four       =
+//=      lanes at a time when built with AVX2 (-mavx2) and one lane           =
+//=      otherwise.  Error is about 2 + 2*ln(p/k) ulp against a correctly     =
+//=      rounded result; for a=1.985, k=0.5, p=100 the max over 1e8 variates  =
+//=      was 10.3 ulp (bpareto_rv() with libm pow: 3.8 ulp).  Cost was        =
+//=      6.8 ns/variate with AVX2, 32 ns scalar, 80 ns for the old pow form   =
+//=   4) The distribution objects (EXPO_DIST, DETER_DIST, BPAR_DIST,          =
+//=      ERLANG_DIST, HYPERX_DIST, LOGNORM_DIST) are set up once and          =
+//=      sampled with dist_sample(&d, s).  dist_sample picks the inline       =
+//=      sampler from the static type of d, so the choice is made by the      =
+//=      compiler and there is no per-variate dispatch                        =
+//=   5) ZIG_EXPO_DIST is an exponential by the Marsaglia-Tsang ziggurat.     =
+//=      Each refill turns ZIG_BUF Philox words into variates in one pass     =
+//=      of multiplies and compares; the ~1.1% that miss the fast path are    =
+//=      redrawn afterwards.  See G. Marsaglia and W. Tsang, "The Ziggurat    =
+//=      Method for Generating Random Variables," J. Stat. Software, 2000.    =
+//=   6) EMP_DIST is an empirical distribution built from a trace: values     =
+//=      are binned (log-spaced when all are positive) and the bins are       =
+//=      drawn by Walker's alias method, uniform over the data range of the   =
+//=      bin, from a single uniform.  A bin holding one distinct value        =
+//=      returns it exactly.  See M. Vose, "A Linear Algorithm for            =
+//=      Generating Random Numbers with a Given Distribution," IEEE Trans.    =
+//=      Software Eng., 1991.  genalias builds and saves the tables           =
+//=   7) dist_value(&d, u) is the variate the sampler makes from the          =
+//=      uniform u, for variance reduction that supplies its own uniforms     =
+//=      (antithetic, quasi-random); the ziggurat has no such map             =
+//=============================================================================
+#ifndef _DISTRIBUTION_INTERFACE_H
+#define _DISTRIBUTION_INTERFACE_H
+
+#include <math.h>
+#include "StreamInterface.h"
+
+//----- Bounded Pareto --------------------------------------------------------
+#ifndef BPar_Has_Been_Defined
+   typedef struct {
+     double A;         // Pareto alpha value
+     double K;         // Lower bound
+     double P;         // Upper bound
+     double D;         // (k/p)^a
+     double NegInvA;   // -1/a
+   } BPAR_PARAMS;
+#define BPar_Has_Been_Defined
+#endif
+
+extern void setup_bpareto(double a, double k, double p, BPAR_PARAMS *bp);
+// Precompute the inversion constants for a bounded Pareto(a, k, p)
+
+extern double bpareto_rv(const BPAR_PARAMS *bp, double z);
+// Bounded Pareto rv for the uniform z in (0,1) (libm, one pow per call)
+
+extern void fill_bpareto(const BPAR_PARAMS *bp, const double *z, double *x, long n);
+// x[i] = bounded Pareto rv for z[i], vectorized; z and x may be the same
+
+extern void pstream_fill_bpareto(PSTREAM s, const BPAR_PARAMS *bp, double *x, long n);
+// Fill x[0..n-1] with bounded Pareto rvs drawn from s
+
+extern double bpareto_mean(const BPAR_PARAMS *bp);
+// Exact mean of the bounded Pareto(a, k, p)
+
+//----- Distribution objects --------------------------------------------------
+#define DIST_BUF 1024   // Variates generated per refill by buffered objects
+#define ZIG_BUF 4096    // Variates generated per ziggurat refill
+#define EMP_BINS 4096   // Default number of bins for an empirical table
+#define EMP_MAGIC "CSIMEMP1" // First 8 bytes of a saved empirical table
+
+typedef struct {        // Exponential
+  double Mean;
+} EXPO_DIST;
+
+typedef struct {        // Deterministic
+  double Value;
+} DETER_DIST;
+
+typedef struct {        // Bounded Pareto, generated DIST_BUF at a time
+  BPAR_PARAMS Par;
+  double Buf[DIST_BUF];
+  int    Next;
+} BPAR_DIST;
+
+typedef struct {        // Exponential by ziggurat, generated ZIG_BUF at a time
+  double Mean;
+  double Buf[ZIG_BUF];  // Unit mean variates
+  int    Next;
+} ZIG_EXPO_DIST;
+
+typedef struct {        // Erlang-k (sum of k exponentials)
+  int    Stages;
+  double StageMean;
+} ERLANG_DIST;
+
+typedef struct {        // Two-phase hyperexponential with balanced means
+  double P1;
+  double Mean1;
+  double Mean2;
+} HYPERX_DIST;
+
+typedef struct {        // Lognormal by Box-Muller, caching the spare normal
+  double Mu;
+  double Sigma;
+  double Spare;
+  int    HasSpare;
+} LOGNORM_DIST;
+
+typedef struct {        // One alias table slot of an empirical distribution
+  double Cut;           // Keep this bin if the fraction is below Cut
+  double Lo;            // Value = Lo + fraction * Scale when kept
+  double Scale;
+  double AliasLo;       // Value = AliasLo + (fraction - Cut) * AliasScale
+  double AliasScale;    //   otherwise (the alias bin, pre-scaled)
+} EMP_BIN;
+
+typedef struct {        // Empirical by alias table, generated DIST_BUF at a time
+  int     Bins;
+  EMP_BIN *Bin;
+  double  Mean;         // Mean of the source values
+  long    Count;        // Number of source values
+  double  Buf[DIST_BUF];
+  int     Next;
+} EMP_DIST;
+
+extern void setup_expo(double mean, EXPO_DIST *d);
+extern void setup_deter(double value, DETER_DIST *d);
+extern void setup_bpar_dist(double a, double k, double p, BPAR_DIST *d);
+extern void setup_zig_expo(double mean, ZIG_EXPO_DIST *d);
+extern void setup_erlang(double mean, int k, ERLANG_DIST *d);
+extern void setup_hyperx(double mean, double var, HYPERX_DIST *d);
+// var must exceed mean^2 (cv > 1), the same restriction as CSIM hyperx()
+extern void setup_lognorm(double mean, double stddev, LOGNORM_DIST *d);
+// mean and stddev are of the lognormal itself, as for CSIM lognormal()
+extern int build_empirical(const double *x, long n, int bins, EMP_DIST *d);
+// Build an alias table with bins bins from x[0..n-1] (finite and >= 0);
+// returns 0 on success, -1 on error
+extern int save_empirical(const char *name, const EMP_DIST *d);
+extern int load_empirical(const char *name, EMP_DIST *d);
+// Write or read a table built by build_empirical(); 0 on success, -1 on error
+extern void free_empirical(EMP_DIST *d);
+extern double emp_mean(const EMP_DIST *d);
+// Exact mean of the table's distribution (Mean is that of the source values)
+
+extern void refill_bpar_dist(BPAR_DIST *d, PSTREAM s);
+// Refill the buffer of d (called by bpar_dist_sample)
+
+extern void refill_zig_expo(ZIG_EXPO_DIST *d, PSTREAM s);
+// Refill the buffer of d (called by zig_expo_sample)
+
+extern void refill_empirical(EMP_DIST *d, PSTREAM s);
+// Refill the buffer of d (called by emp_sample)
+
+static inline double expo_sample(EXPO_DIST *d, PSTREAM s)
+{
+  return -d->Mean * log(pstream_uniform01(s));
+}
+
+static inline double deter_sample(DETER_DIST *d, PSTREAM s)
+{
+  (void)s;
+  return d->Value;
+}
+
+static inline double bpar_dist_sample(BPAR_DIST *d, PSTREAM s)
+{
+  if (d->Next == DIST_BUF)
+    refill_bpar_dist(d, s);
+  return d->Buf[d->Next++];
+}
+
+static inline double zig_expo_sample(ZIG_EXPO_DIST *d, PSTREAM s)
+{
+  if (d->Next == ZIG_BUF)
+    refill_zig_expo(d, s);
+  return d->Mean * d->Buf[d->Next++];
+}
+
+static inline double erlang_sample(ERLANG_DIST *d, PSTREAM s)
+{
+  double prod = 1.0;
+  int    i;
+
+  // One log for all k stages
+  for (i = 0; i < d->Stages; i++)
+    prod = prod * pstream_uniform01(s);
+  return -d->StageMean * log(prod);
+}
+
+static inline double hyperx_sample(HYPERX_DIST *d, PSTREAM s)
+{
+  double mean = (pstream_uniform01(s) < d->P1) ? d->Mean1 : d->Mean2;
+
+  return -mean * log(pstream_uniform01(s));
+}
+
+static inline double lognorm_sample(LOGNORM_DIST *d, PSTREAM s)
+{
+  double r, theta;
+
+  if (d->HasSpare)
+  {
+    d->HasSpare = 0;
+    return exp(d->Mu + d->Sigma * d->Spare);
+  }
+  r = sqrt(-2.0 * log(pstream_uniform01(s)));
+  theta = 6.283185307179586477 * pstream_uniform01(s);
+  d->Spare = r * sin(theta);
+  d->HasSpare = 1;
+  return exp(d->Mu + d->Sigma * r * cos(theta));
+}
+
+static inline double emp_value(const EMP_DIST *d, double u)
+{
+  const EMP_BIN *b;
+  int           i;
+
+  // Whole part picks the slot, the fraction decides bin or alias and the
+  // position within it; u * Bins can round up when Bins is not 2^k
+  u = u * d->Bins;
+  i = (int)u;
+  if (i == d->Bins)
+    i--;
+  b = &d->Bin[i];
+  u -= i;
+  return (u < b->Cut) ? b->Lo + u * b->Scale
+                      : b->AliasLo + (u - b->Cut) * b->AliasScale;
+}
+
+static inline double emp_sample(EMP_DIST *d, PSTREAM s)
+{
+  if (d->Next == DIST_BUF)
+    refill_empirical(d, s);
+  return d->Buf[d->Next++];
+}
+
+#define dist_sample(d, s) _Generic((d),       \
+          EXPO_DIST *:    expo_sample,        \
+          DETER_DIST *:   deter_sample,       \
+          BPAR_DIST *:    bpar_dist_sample,   \
+          ZIG_EXPO_DIST *: zig_expo_sample,   \
+          ERLANG_DIST *:  erlang_sample,      \
+          HYPERX_DIST *:  hyperx_sample,      \
+          LOGNORM_DIST *: lognorm_sample,     \
+          EMP_DIST *:     emp_sample)((d), (s))
+
+static inline double expo_value(EXPO_DIST *d, double u)
+{
+  return -d->Mean * log(u);
+}
+
+static inline double deter_value(DETER_DIST *d, double u)
+{
+  (void)u;
+  return d->Value;
+}
+
+static inline double bpar_dist_value(BPAR_DIST *d, double u)
+{
+  return bpareto_rv(&d->Par, u);
+}
+
+static inline double emp_dist_value(EMP_DIST *d, double u)
+{
+  return emp_value(d, u);
+}
+
+#define dist_value(d, u) _Generic((d),        \
+          EXPO_DIST *:    expo_value,         \
+          DETER_DIST *:   deter_value,        \
+          BPAR_DIST *:    bpar_dist_value,    \
+          EMP_DIST *:     emp_dist_value)((d), (u))
+
+#endif
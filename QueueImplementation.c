@@ -105,3 +105,204 @@ double Sum(Queue *Q)
 }
 
 
+
+//----- Priority queue (4-ary heap) -------------------------------------------
+#define PQ_ARITY 4
+
+static void SiftUp(PQueue *P, int i)
+{
+  int    h = P->Heap[i];
+  double key = P->Key[h];
+  int    parent;
+
+  while (i > 0)
+  {
+    parent = (i - 1) / PQ_ARITY;
+    if (P->Key[P->Heap[parent]] <= key)
+      break;
+    P->Heap[i] = P->Heap[parent];
+    P->Pos[P->Heap[i]] = i;
+    i = parent;
+  }
+  P->Heap[i] = h;
+  P->Pos[h] = i;
+}
+
+static void SiftDown(PQueue *P, int i)
+{
+  int    h = P->Heap[i];
+  double key = P->Key[h];
+  int    child, last, best, c;
+
+  while (1)
+  {
+    child = PQ_ARITY * i + 1;
+    if (child >= P->Count)
+      break;
+
+    // Find the smallest of up to PQ_ARITY children
+    last = child + PQ_ARITY;
+    if (last > P->Count)
+      last = P->Count;
+    best = child;
+    for (c = child + 1; c < last; c++)
+    {
+      if (P->Key[P->Heap[c]] < P->Key[P->Heap[best]])
+        best = c;
+    }
+
+    if (P->Key[P->Heap[best]] >= key)
+      break;
+    P->Heap[i] = P->Heap[best];
+    P->Pos[P->Heap[i]] = i;
+    i = best;
+  }
+  P->Heap[i] = h;
+  P->Pos[h] = i;
+}
+
+static int GrowPQ(PQueue *P)
+{
+  int    capacity = (P->Capacity > 0) ? 2 * P->Capacity : 16;
+  double *key;
+  int    *heap;
+  int    *pos;
+  int    i;
+
+  key = (double *) realloc(P->Key, capacity * sizeof(double));
+  if (key != NULL)
+    P->Key = key;
+  heap = (int *) realloc(P->Heap, capacity * sizeof(int));
+  if (heap != NULL)
+    P->Heap = heap;
+  pos = (int *) realloc(P->Pos, capacity * sizeof(int));
+  if (pos != NULL)
+    P->Pos = pos;
+
+  if (key == NULL || heap == NULL || pos == NULL)
+  {
+    fprintf(stderr, "system storage is exhausted");
+    return 0;
+  }
+
+  // New handles are free and parked past the end of the heap
+  for (i = P->Capacity; i < capacity; i++)
+  {
+    P->Heap[i] = i;
+    P->Pos[i] = -1;
+  }
+  P->Capacity = capacity;
+  return 1;
+}
+
+void InitializePQ(PQueue *P, int Capacity)
+{
+  P->Key = NULL;
+  P->Heap = NULL;
+  P->Pos = NULL;
+  P->Count = 0;
+  P->Capacity = 0;
+  P->Total = 0.0;
+
+  while (P->Capacity < Capacity)
+  {
+    if (!GrowPQ(P))
+      break;
+  }
+}
+
+void FreePQ(PQueue *P)
+{
+  free(P->Key);
+  free(P->Heap);
+  free(P->Pos);
+  InitializePQ(P, 0);
+}
+
+int PQEmpty(PQueue *P)
+{
+  return (P->Count == 0);
+}
+
+int PQFull(PQueue *P)
+{
+  return (P->Count == P->Capacity && !GrowPQ(P));
+}
+
+int InsertPQ(double R, PQueue *P)
+{
+  int h;
+
+  if (PQFull(P))
+    return -1;
+
+  // Take the free handle parked in the first unused slot
+  h = P->Heap[P->Count];
+  P->Key[h] = R;
+  P->Count++;
+  P->Total = P->Total + R;
+  SiftUp(P, P->Count - 1);
+
+  return h;
+}
+
+int RemoveMin(PQueue *P, double *F)
+{
+  int h;
+  int last;
+
+  if (P->Count == 0)
+  {
+    fprintf(stderr, "attempt to remove item from empty PQueue");
+    return -1;
+  }
+
+  h = P->Heap[0];
+  *F = P->Key[h];
+  P->Count--;
+  P->Total = P->Total - *F;
+
+  // Move the last item to the root and park the freed handle in its slot
+  last = P->Heap[P->Count];
+  P->Heap[P->Count] = h;
+  P->Pos[h] = -1;
+  if (P->Count > 0)
+  {
+    P->Heap[0] = last;
+    SiftDown(P, 0);
+  }
+  else
+    P->Total = 0.0;   // Drop accumulated round-off once empty
+
+  return h;
+}
+
+double MinPQ(PQueue *P)
+{
+  if (P->Count == 0)
+    return 0.0;
+  return P->Key[P->Heap[0]];
+}
+
+void DecreaseKey(int H, double R, PQueue *P)
+{
+  if (H < 0 || H >= P->Capacity || P->Pos[H] < 0)
+  {
+    fprintf(stderr, "attempt to decrease key of item not in PQueue");
+    return;
+  }
+  if (R > P->Key[H])
+  {
+    fprintf(stderr, "attempt to increase key with DecreaseKey");
+    return;
+  }
+
+  P->Total = P->Total - (P->Key[H] - R);
+  P->Key[H] = R;
+  SiftUp(P, P->Pos[H]);
+}
+
+double SumPQ(PQueue *P)
+{
+  return P->Total;
+}
@@ -33,3 +33,48 @@ extern void Remove(Queue *Q, double *F);
 
 extern double Sum(Queue *Q);
 // Add all nodes in the queue Q 
+
+//----- Priority queue --------------------------------------------------------
+// An addressable min-priority queue for size-based disciplines (SJF, SRPT).
+// It is a 4-ary heap kept in three parallel arrays that grow by doubling, so
+// there is no malloc per item.  InsertPQ returns a handle that stays valid
+// until the item is removed; free handles are parked in Heap[Count..].
+
+#ifndef PQueue_Has_Been_Defined
+   typedef struct {
+     double *Key;      // Key[h] is the key of handle h
+     int    *Heap;     // Heap[i] is the handle at heap slot i
+     int    *Pos;      // Pos[h] is the heap slot of handle h, -1 if free
+     int    Count;     // Number of items in the heap
+     int    Capacity;  // Number of slots allocated
+     double Total;     // Running sum of all keys in the heap
+   } PQueue;
+#define PQueue_Has_Been_Defined
+#endif
+
+extern void InitializePQ(PQueue *P, int Capacity);
+// Initialize P to be the empty priority queue with room for Capacity items
+
+extern void FreePQ(PQueue *P);
+// Release the storage held by P
+
+extern int PQEmpty(PQueue *P);
+// Returns TRUE == 1 if and only if P is empty
+
+extern int PQFull(PQueue *P);
+// Returns TRUE == 1 if and only if P is full and cannot grow
+
+extern int InsertPQ(double R, PQueue *P);
+// Insert key R into P and return its handle (-1 if P is full)
+
+extern int RemoveMin(PQueue *P, double *F);
+// If P is non-empty, remove the smallest key, put it in F, return its handle
+
+extern double MinPQ(PQueue *P);
+// Returns the smallest key in P without removing it (0.0 if P is empty)
+
+extern void DecreaseKey(int H, double R, PQueue *P);
+// Lower the key of handle H to R (R must not be larger than the old key)
+
+extern double SumPQ(PQueue *P);
+// Sum of all keys in P in O(1)
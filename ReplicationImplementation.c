@@ -0,0 +1,277 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "ReplicationInterface.h"
+
+typedef struct {          // One observation on its way up the pipe
+  long   Index;
+  double Out[REP_WIDTH_MAX];
+} REP_MSG;                // Well under PIPE_BUF, so each write is atomic
+
+//=============================================================================
+//==  Function for a worker: claim indices until they run out                ==
+//=============================================================================
+static void rep_worker(atomic_long *next, long max, int width, int fd,
+                       REP_RUN run, void *arg)
+{
+  REP_MSG  msg;
+  size_t   len = sizeof(long) + width * sizeof(double);
+
+  while ((msg.Index = atomic_fetch_add(next, 1)) < max)
+  {
+    run(msg.Index, msg.Out, arg);
+    if (write(fd, &msg, len) != (ssize_t) len)
+      _exit(1);
+  }
+  _exit(0);
+}
+
+//=============================================================================
+//==  Function to read one whole message (0 at end of file)                  ==
+//=============================================================================
+static int read_msg(int fd, REP_MSG *msg, size_t len)
+{
+  size_t   got = 0;
+  ssize_t  n;
+
+  while (got < len)
+  {
+    n = read(fd, (char *) msg + got, len - got);
+    if (n <= 0)
+      return 0;
+    got += n;
+  }
+  return 1;
+}
+
+long run_replications(int procs, long first, long max, int width,
+                      REP_RUN run, REP_MERGE merge, void *arg)
+{
+  atomic_long *next;      // Next index to claim (shared)
+  pid_t    *pid;          // Workers
+  char     *have;         // have[i] if observation i has arrived
+  double   *store;        // Observations waiting for their turn
+  REP_MSG  msg;
+  size_t   len = sizeof(long) + width * sizeof(double);
+  long     merged = first; // Observations merged so far
+  int      stop = 0;      // merge() asked to stop
+  int      started = 0;   // Workers forked
+  int      fd[2];
+  int      w;
+
+  if ((width < 1) || (width > REP_WIDTH_MAX))
+  {
+    fprintf(stderr, "ERROR observation width %d (1 to %d) \n",
+      width, REP_WIDTH_MAX);
+    return -1;
+  }
+
+  // One process: no workers, same observations in the same order
+  if (procs <= 1)
+  {
+    while ((merged < max) && !stop)
+    {
+      run(merged, msg.Out, arg);
+      stop = merge(merged, msg.Out, arg);
+      merged++;
+    }
+    return merged;
+  }
+
+  next = (atomic_long *) mmap(NULL, sizeof(atomic_long),
+    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (next == MAP_FAILED)
+  {
+    fprintf(stderr, "ERROR in mapping the shared replication counter \n");
+    return -1;
+  }
+  atomic_init(next, first);
+  pid = (pid_t *) malloc(procs * sizeof(pid_t));
+  have = (char *) calloc(max, 1);
+  store = (double *) malloc(max * width * sizeof(double));
+  if ((pid == NULL) || (have == NULL) || (store == NULL) || (pipe(fd) != 0))
+  {
+    fprintf(stderr, "ERROR in setting up %d replication workers \n", procs);
+    free(pid);  free(have);  free(store);
+    munmap(next, sizeof(atomic_long));
+    return -1;
+  }
+
+  fflush(NULL);
+  for (started=0; started<procs; started++)
+  {
+    pid[started] = fork();
+    if (pid[started] < 0)
+      break;
+    if (pid[started] == 0)
+    {
+      close(fd[0]);
+      rep_worker(next, max, width, fd[1], run, arg);
+    }
+  }
+  close(fd[1]);
+  if (started < procs)
+    fprintf(stderr, "ERROR only %d of %d replication workers started \n",
+      started, procs);
+  if (started == 0)
+    merged = -1;
+
+  // Merge the longest prefix that has arrived after every message
+  while ((started > 0) && !stop && (merged < max) &&
+         read_msg(fd[0], &msg, len))
+  {
+    if ((msg.Index < 0) || (msg.Index >= max) || have[msg.Index])
+      continue;
+    memcpy(store + msg.Index * width, msg.Out, width * sizeof(double));
+    have[msg.Index] = 1;
+    while ((merged < max) && have[merged] && !stop)
+    {
+      stop = merge(merged, store + merged * width, arg);
+      merged++;
+    }
+  }
+  if ((started > 0) && !stop && (merged < max))
+  {
+    fprintf(stderr, "ERROR replication worker failed at observation %ld \n",
+      merged);
+    merged = -1;
+  }
+
+  // Work in progress past the stopping point is discarded
+  atomic_store(next, max);
+  for (w=0; w<started; w++)
+    kill(pid[w], SIGKILL);
+  for (w=0; w<started; w++)
+    waitpid(pid[w], NULL, 0);
+  close(fd[0]);
+
+  free(pid);
+  free(have);
+  free(store);
+  munmap(next, sizeof(atomic_long));
+  return merged;
+}
+
+//=============================================================================
+//==  Fork-per-observation version: children write their result into shared  ==
+//==  memory and the parent learns of it from waitpid()                      ==
+//=============================================================================
+long run_replications_forked(int procs, long first, long max, int width,
+                             REP_RUN run, REP_MERGE merge, void *arg)
+{
+  double   *store;        // Observations (shared)
+  size_t   bytes;         // Size of store
+  pid_t    *pid;          // Running children (0 = free slot)
+  long     *slot_index;   // Observation of each child
+  char     *have;         // have[i] if observation i is done
+  pid_t    done;          // Child that exited
+  long     launched = first; // Observations started
+  long     merged = first; // Observations merged so far
+  int      running = 0;   // Children running
+  int      stop = 0;      // merge() asked to stop
+  int      failed = 0;    // A child failed
+  int      status;        // Its wait status
+  int      w;
+
+  if ((width < 1) || (width > REP_WIDTH_MAX))
+  {
+    fprintf(stderr, "ERROR observation width %d (1 to %d) \n",
+      width, REP_WIDTH_MAX);
+    return -1;
+  }
+  if (procs < 1)
+    procs = 1;
+
+  bytes = max * width * sizeof(double);
+  store = (double *) mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  pid = (pid_t *) calloc(procs, sizeof(pid_t));
+  slot_index = (long *) calloc(procs, sizeof(long));
+  have = (char *) calloc(max, 1);
+  if ((store == MAP_FAILED) || (pid == NULL) || (slot_index == NULL) ||
+      (have == NULL))
+  {
+    fprintf(stderr, "ERROR in setting up %d replication children \n", procs);
+    if (store != MAP_FAILED)
+      munmap(store, bytes);
+    free(pid);  free(slot_index);  free(have);
+    return -1;
+  }
+
+  while (!stop && !failed && (merged < max))
+  {
+    // Keep procs children going from the caller's state
+    for (w=0; (w < procs) && (launched < max); w++)
+    {
+      if (pid[w] != 0)
+        continue;
+      fflush(NULL);
+      pid[w] = fork();
+      if (pid[w] < 0)
+      {
+        fprintf(stderr, "ERROR in forking replication %ld \n", launched);
+        pid[w] = 0;
+        failed = 1;
+        break;
+      }
+      if (pid[w] == 0)
+      {
+        run(launched, store + launched * width, arg);
+        _exit(0);
+      }
+      slot_index[w] = launched++;
+      running++;
+    }
+    if (failed || (running == 0))
+      break;
+
+    done = waitpid(-1, &status, 0);
+    for (w=0; w<procs; w++)
+      if ((done > 0) && (pid[w] == done))
+        break;
+    if (w == procs)
+      continue;
+    pid[w] = 0;
+    running--;
+    if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+    {
+      fprintf(stderr, "ERROR replication %ld did not finish \n",
+        slot_index[w]);
+      failed = 1;
+      break;
+    }
+    have[slot_index[w]] = 1;
+
+    while ((merged < max) && have[merged] && !stop)
+    {
+      stop = merge(merged, store + merged * width, arg);
+      merged++;
+    }
+  }
+
+  // Work in progress past the stopping point is discarded
+  for (w=0; w<procs; w++)
+    if (pid[w] != 0)
+      kill(pid[w], SIGKILL);
+  for (w=0; w<procs; w++)
+    if (pid[w] != 0)
+      waitpid(pid[w], NULL, 0);
+
+  munmap(store, bytes);
+  free(pid);
+  free(slot_index);
+  free(have);
+  return failed ? -1 : merged;
+}
+
+int rep_procs(void)
+{
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return (n < 1) ? 1 : (int) n;
+}
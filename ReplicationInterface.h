@@ -0,0 +1,58 @@
+//=========================================== file = ReplicationInterface.h ===
+//=  Independent replications run by parallel worker processes                =
+//=============================================================================
+//=  Notes:                                                                   =
+//=   1) run_replications() forks procs workers.  Each claims the next        =
+//=      observation index from a counter in shared memory, computes it       =
+//=      with run() (which must seed its random streams from the index        =
+//=      alone) and sends the result up a pipe                                =
+//=   2) The caller merges the observations with merge() strictly in          =
+//=      index order, and stops at the first index where merge() says the     =
+//=      pooled CI is good enough.  Stopping on a prefix avoids the bias      =
+//=      of keeping whichever replications finish first (long runs tend to    =
+//=      be the ones with long response times), and makes the result the      =
+//=      same for any number of workers                                       =
+//=   3) Workers are processes, not threads, because CSIM keeps the           =
+//=      simulation in globals; stdout is flushed before the fork and         =
+//=      workers leave with _exit(), so nothing is printed twice.  Workers    =
+//=      still running at the stop are killed                                 =
+//=   4) procs = 1 runs everything in the calling process                     =
+//=   5) run_replications_forked() instead forks a fresh child of the         =
+//=      caller for every observation (at most procs at a time), so each      =
+//=      one starts from the caller's state at the call, shared copy-on-      =
+//=      write: a model warmed up once can fork its replications from the     =
+//=      warm state.  Results come back in shared memory and a child that     =
+//=      does not exit cleanly is an error.  The observations share their     =
+//=      initial state, so the CI is for the mean given that state            =
+//=   6) first > 0 resumes: observations 0..first-1 are taken as merged       =
+//=      already (e.g. restored from a checkpoint) and the run continues      =
+//=      at index first, with the same results as an unbroken run             =
+//=============================================================================
+#ifndef _REPLICATION_INTERFACE_H
+#define _REPLICATION_INTERFACE_H
+
+#define REP_WIDTH_MAX 32  // Most doubles in one observation
+
+typedef void (*REP_RUN)(long index, double *out, void *arg);
+// Compute observation index into out[0..width-1] (runs in a worker)
+
+typedef int (*REP_MERGE)(long index, const double *out, void *arg);
+// Add observation index (in index order); nonzero stops the replications
+
+// defined operations
+extern long run_replications(int procs, long first, long max, int width,
+                             REP_RUN run, REP_MERGE merge, void *arg);
+// Run observations first..max-1 of width doubles on procs workers until
+// merge() returns nonzero; returns the number merged in all (counting the
+// first), or -1 if a worker failed or could not be started
+
+extern long run_replications_forked(int procs, long first, long max,
+                                    int width, REP_RUN run, REP_MERGE merge,
+                                    void *arg);
+// As run_replications(), but observation i runs in a child forked from the
+// caller's current state, even for procs = 1
+
+extern int rep_procs(void);
+// Number of online processors (the default for procs)
+
+#endif
@@ -0,0 +1,702 @@
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "StatsInterface.h"
+
+#define T_EXPANSION_DF 30     // Above this df the expansion alone is used
+
+void stats_reset(STATS *st)
+{
+  st->N = 0;
+  st->Mean = 0.0;
+  st->M2 = 0.0;
+}
+
+void stats_add(STATS *st, double x)
+{
+  double delta = x - st->Mean;
+
+  st->N++;
+  st->Mean += delta / st->N;
+  st->M2 += delta * (x - st->Mean);
+}
+
+double stats_mean(const STATS *st)
+{
+  return st->Mean;
+}
+
+double stats_var(const STATS *st)
+{
+  if (st->N < 2)
+    return 0.0;
+  return st->M2 / (st->N - 1);
+}
+
+double stats_half_width(const STATS *st, double level)
+{
+  if (st->N < 2)
+    return HUGE_VAL;
+  return t_quantile(0.5 + 0.5 * level, st->N - 1) * sqrt(stats_var(st) / st->N);
+}
+
+//=============================================================================
+//==  Control variates: the co-moments of (y, c) are updated like Welford's  ==
+//==  variance, and beta solves S_cc beta = S_cy                             ==
+//=============================================================================
+void cv_reset(CV_STATS *cv, int q, const double *mu)
+{
+  int      i, j;
+
+  if (q > CV_MAX)
+  {
+    fprintf(stderr, "ERROR at most %d control variates \n", CV_MAX);
+    q = CV_MAX;
+  }
+  cv->Q = q;
+  cv->N = 0;
+  for (i = 0; i < q; i++)
+    cv->Mu[i] = mu[i];
+  for (i = 0; i <= CV_MAX; i++)
+  {
+    cv->Mean[i] = 0.0;
+    for (j = 0; j <= CV_MAX; j++)
+      cv->M2[i][j] = 0.0;
+  }
+}
+
+void cv_add(CV_STATS *cv, double y, const double *c)
+{
+  double   z[CV_MAX + 1];        // This observation
+  double   delta[CV_MAX + 1];    // Its deviation from the old means
+  int      i, j;
+
+  z[0] = y;
+  for (i = 0; i < cv->Q; i++)
+    z[i + 1] = c[i];
+
+  cv->N++;
+  for (i = 0; i <= cv->Q; i++)
+  {
+    delta[i] = z[i] - cv->Mean[i];
+    cv->Mean[i] += delta[i] / cv->N;
+  }
+  for (i = 0; i <= cv->Q; i++)
+    for (j = 0; j <= cv->Q; j++)
+      cv->M2[i][j] += delta[i] * (z[j] - cv->Mean[j]);
+}
+
+void cv_raw(const CV_STATS *cv, STATS *st)
+{
+  st->N = cv->N;
+  st->Mean = cv->Mean[0];
+  st->M2 = cv->M2[0][0];
+}
+
+//-----------------------------------------------------------------------------
+//--  Solve for beta and for the quadratic form d' S_cc^-1 d, d = cbar - Mu, --
+//--  by Gaussian elimination with partial pivoting on both right sides      --
+//-----------------------------------------------------------------------------
+static int cv_solve(const CV_STATS *cv, double *beta, double *quad)
+{
+  double   a[CV_MAX][CV_MAX + 2]; // S_cc | S_cy | d
+  double   x[CV_MAX];            // S_cc^-1 d
+  double   tol = 0.0;            // Pivot below this means collinear
+  double   f, t;
+  int      q = cv->Q;
+  int      i, j, k, p;
+
+  if ((q < 1) || (cv->N < q + 3))
+    return -1;
+
+  for (i = 0; i < q; i++)
+  {
+    for (j = 0; j < q; j++)
+      a[i][j] = cv->M2[i + 1][j + 1];
+    a[i][q] = cv->M2[i + 1][0];
+    a[i][q + 1] = cv->Mean[i + 1] - cv->Mu[i];
+    if (a[i][i] > tol)
+      tol = a[i][i];
+  }
+  tol *= 1.0e-12;
+
+  for (k = 0; k < q; k++)
+  {
+    p = k;
+    for (i = k + 1; i < q; i++)
+      if (fabs(a[i][k]) > fabs(a[p][k]))
+        p = i;
+    if (fabs(a[p][k]) <= tol)
+      return -1;
+    for (j = k; j < q + 2; j++)
+    {
+      t = a[k][j];
+      a[k][j] = a[p][j];
+      a[p][j] = t;
+    }
+    for (i = k + 1; i < q; i++)
+    {
+      f = a[i][k] / a[k][k];
+      for (j = k; j < q + 2; j++)
+        a[i][j] -= f * a[k][j];
+    }
+  }
+
+  for (i = q - 1; i >= 0; i--)
+  {
+    beta[i] = a[i][q];
+    x[i] = a[i][q + 1];
+    for (j = i + 1; j < q; j++)
+    {
+      beta[i] -= a[i][j] * beta[j];
+      x[i] -= a[i][j] * x[j];
+    }
+    beta[i] /= a[i][i];
+    x[i] /= a[i][i];
+  }
+
+  *quad = 0.0;
+  for (i = 0; i < q; i++)
+    *quad += (cv->Mean[i + 1] - cv->Mu[i]) * x[i];
+  return 0;
+}
+
+int cv_beta(const CV_STATS *cv, double *beta)
+{
+  double   quad;
+
+  return cv_solve(cv, beta, &quad);
+}
+
+double cv_mean(const CV_STATS *cv)
+{
+  double   beta[CV_MAX];
+  double   quad;
+  double   y = cv->Mean[0];
+  int      i;
+
+  if (cv_solve(cv, beta, &quad) == 0)
+    for (i = 0; i < cv->Q; i++)
+      y -= beta[i] * (cv->Mean[i + 1] - cv->Mu[i]);
+  return y;
+}
+
+double cv_half_width(const CV_STATS *cv, double level)
+{
+  double   beta[CV_MAX];
+  double   quad;
+  double   sse;                  // Residual sum of squares
+  STATS    raw;
+  long     df;
+  int      i;
+
+  if (cv_solve(cv, beta, &quad) != 0)
+  {
+    cv_raw(cv, &raw);
+    return stats_half_width(&raw, level);
+  }
+
+  sse = cv->M2[0][0];
+  for (i = 0; i < cv->Q; i++)
+    sse -= beta[i] * cv->M2[i + 1][0];
+  if (sse < 0.0)
+    sse = 0.0;
+  df = cv->N - cv->Q - 1;
+  return t_quantile(0.5 + 0.5 * level, df) *
+         sqrt(sse / df * (1.0 / cv->N + quad));
+}
+
+//=============================================================================
+//==  Normal quantile by P. Acklam's rational approximation (relative error  ==
+//==  1.15e-9) with one Halley step against erfc()                           ==
+//=============================================================================
+double normal_quantile(double p)
+{
+  static const double a[6] = {-3.969683028665376e+01,  2.209460984245205e+02,
+                              -2.759285104469687e+02,  1.383577518672690e+02,
+                              -3.066479806614716e+01,  2.506628277459239e+00};
+  static const double b[5] = {-5.447609879822406e+01,  1.615858368580409e+02,
+                              -1.556989798598866e+02,  6.680131188771972e+01,
+                              -1.328068155288572e+01};
+  static const double c[6] = {-7.784894002430293e-03, -3.223964580411365e-01,
+                              -2.400758277161838e+00, -2.549732539343734e+00,
+                               4.374664141464968e+00,  2.938163982698783e+00};
+  static const double d[4] = { 7.784695709041462e-03,  3.224671290700398e-01,
+                               2.445134137142996e+00,  3.754408661907416e+00};
+  double q, r, x, e;
+
+  if (p <= 0.0 || p >= 1.0)
+  {
+    fprintf(stderr, "normal quantile needs 0 < p < 1");
+    return (p <= 0.0) ? -HUGE_VAL : HUGE_VAL;
+  }
+
+  if (p < 0.02425)
+  {
+    q = sqrt(-2.0 * log(p));
+    x = (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+        ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+  }
+  else if (p <= 1.0 - 0.02425)
+  {
+    q = p - 0.5;
+    r = q * q;
+    x = (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5]) * q /
+        (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1.0);
+  }
+  else
+  {
+    q = sqrt(-2.0 * log(1.0 - p));
+    x = -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+         ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+  }
+
+  // Halley refinement to full double precision
+  e = 0.5 * erfc(-x / sqrt(2.0)) - p;
+  r = e * sqrt(2.0 * M_PI) * exp(0.5 * x * x);
+  return x - r / (1.0 + 0.5 * x * r);
+}
+
+//=============================================================================
+//==  Regularized upper incomplete gamma Q(a, x): the series for P below     ==
+//==  a + 1, otherwise the continued fraction (modified Lentz)               ==
+//=============================================================================
+static double gamma_q(double a, double x)
+{
+  double   lead, sum, term, b, c, d, h, an;
+  int      i;
+
+  if (x <= 0.0)
+    return 1.0;
+  lead = exp(a * log(x) - x - lgamma(a));
+
+  if (x < a + 1.0)
+  {
+    term = sum = 1.0 / a;
+    for (i = 1; i < 1000; i++)
+    {
+      term *= x / (a + i);
+      sum += term;
+      if (fabs(term) < fabs(sum) * 1.0e-15)
+        break;
+    }
+    return 1.0 - sum * lead;
+  }
+
+  b = x + 1.0 - a;
+  c = 1.0 / 1.0e-300;
+  d = 1.0 / b;
+  h = d;
+  for (i = 1; i < 1000; i++)
+  {
+    an = -i * (i - a);
+    b += 2.0;
+    d = an * d + b;
+    if (fabs(d) < 1.0e-300) d = 1.0e-300;
+    c = b + an / c;
+    if (fabs(c) < 1.0e-300) c = 1.0e-300;
+    d = 1.0 / d;
+    h *= d * c;
+    if (fabs(d * c - 1.0) < 1.0e-15)
+      break;
+  }
+  return lead * h;
+}
+
+double chi2_sf(double x, long df)
+{
+  return gamma_q(0.5 * df, 0.5 * x);
+}
+
+double ks_sf(double d, long n)
+{
+  double   sn = sqrt((double)n);
+  double   lambda = (sn + 0.12 + 0.11 / sn) * d;
+  double   sum = 0.0;
+  double   term;
+  int      k;
+
+  if (lambda <= 0.0)
+    return 1.0;
+
+  // Small lambda: the theta-function form of the cdf converges fast
+  if (lambda < 1.0)
+  {
+    for (k = 1; k <= 10; k++)
+      sum += exp(-(2 * k - 1) * (2 * k - 1) * M_PI * M_PI /
+                 (8.0 * lambda * lambda));
+    return 1.0 - sqrt(2.0 * M_PI) / lambda * sum;
+  }
+
+  for (k = 1; k <= 100; k++)
+  {
+    term = exp(-2.0 * k * k * lambda * lambda);
+    sum += (k % 2) ? term : -term;
+    if (term < 1.0e-16)
+      break;
+  }
+  return 2.0 * sum;
+}
+
+//=============================================================================
+//==  Ratio estimator: Welford co-moments of (y, x), and the CI from the     ==
+//==  sample variance of y - r x over the mean of x                          ==
+//=============================================================================
+void ratio_reset(RATIO_STATS *r)
+{
+  r->N = 0;
+  r->MeanY = r->MeanX = 0.0;
+  r->Syy = r->Sxy = r->Sxx = 0.0;
+}
+
+void ratio_add(RATIO_STATS *r, double y, double x)
+{
+  double dy = y - r->MeanY;
+  double dx = x - r->MeanX;
+
+  r->N++;
+  r->MeanY += dy / r->N;
+  r->MeanX += dx / r->N;
+  r->Syy += dy * (y - r->MeanY);
+  r->Sxy += dy * (x - r->MeanX);
+  r->Sxx += dx * (x - r->MeanX);
+}
+
+double ratio_mean(const RATIO_STATS *r)
+{
+  if (r->MeanX == 0.0)
+    return 0.0;
+  return r->MeanY / r->MeanX;
+}
+
+double ratio_half_width(const RATIO_STATS *r, double level)
+{
+  double   q = ratio_mean(r);
+  double   var;                  // Sample variance of y - q x
+
+  if ((r->N < 2) || (r->MeanX == 0.0))
+    return HUGE_VAL;
+  var = (r->Syy - 2.0 * q * r->Sxy + q * q * r->Sxx) / (r->N - 1);
+  if (var < 0.0)
+    var = 0.0;
+  return t_quantile(0.5 + 0.5 * level, r->N - 1) * sqrt(var / r->N) /
+         fabs(r->MeanX);
+}
+
+//=============================================================================
+//==  MSER-5 warm-up detection on a bounded set of batch means               ==
+//=============================================================================
+void mser_reset(MSER *m)
+{
+  m->N = 0;
+  m->Size = MSER_BATCH;
+  m->Count = 0;
+  m->Fill = 0;
+  m->Sum = 0.0;
+}
+
+int mser_add(MSER *m, double x)
+{
+  int      i;
+
+  m->N++;
+  m->Sum += x;
+  if (++m->Fill < m->Size)
+    return 0;
+
+  // Full: merge adjacent pairs, so each kept batch covers twice as much
+  if (m->Count == MSER_MAX)
+  {
+    for (i = 0; i < MSER_MAX / 2; i++)
+      m->Batch[i] = 0.5 * (m->Batch[2 * i] + m->Batch[2 * i + 1]);
+    m->Count = MSER_MAX / 2;
+    m->Size *= 2;
+    if (m->Fill < m->Size)
+      return 0;
+  }
+  m->Batch[m->Count++] = m->Sum / m->Fill;
+  m->Fill = 0;
+  m->Sum = 0.0;
+  return 1;
+}
+
+long mser_truncation(const MSER *m)
+{
+  STATS    tail;         // Batches d..Count-1
+  double   z;            // MSER statistic for d
+  double   best = HUGE_VAL;
+  int      best_d = 0;
+  int      d;
+
+  if (m->Count < MSER_MIN)
+    return -1;
+
+  // Welford from the newest batch back, so each d costs one update
+  stats_reset(&tail);
+  for (d = m->Count - 1; d >= 0; d--)
+  {
+    stats_add(&tail, m->Batch[d]);
+    if (2 * d > m->Count)
+      continue;
+    z = tail.M2 / ((double) tail.N * tail.N);
+    if (z <= best)
+    {
+      best = z;
+      best_d = d;
+    }
+  }
+  if (2 * best_d >= m->Count)
+    return -1;
+  return best_d * m->Size;
+}
+
+//=============================================================================
+//==  Log-linear (HDR) histogram; hdr_record() is inline in the header       ==
+//=============================================================================
+void hdr_reset(HDR *h)
+{
+  memset(h, 0, sizeof(HDR));
+}
+
+void hdr_merge(HDR *h, const HDR *from)
+{
+  int      k;
+
+  for (k = 0; k < HDR_BINS; k++)
+    h->Count[k] += from->Count[k];
+  h->N += from->N;
+}
+
+double hdr_percentile(const HDR *h, double p)
+{
+  union { double d; int64_t i; } lo, hi;
+  long     rank;         // Values at or below the quantile
+  long     seen = 0;
+  int      k;
+
+  if (h->N == 0)
+    return 0.0;
+  rank = (long) ceil(p * h->N);
+  if (rank < 1)
+    rank = 1;
+  for (k = 0; k < HDR_BINS - 1; k++)
+  {
+    seen += h->Count[k];
+    if (seen >= rank)
+      break;
+  }
+
+  // Bucket k is [lo, hi): its bits are the index back in place
+  lo.i = ((int64_t) k + HDR_BASE) << (52 - HDR_SUB_BITS);
+  hi.i = ((int64_t) k + 1 + HDR_BASE) << (52 - HDR_SUB_BITS);
+  return 0.5 * (lo.d + hi.d);
+}
+
+//=============================================================================
+//==  Merging t-digest                                                       ==
+//=============================================================================
+static int cmp_centroid(const void *a, const void *b)
+{
+  double x = ((const TD_CENTROID *) a)->Mean;
+  double y = ((const TD_CENTROID *) b)->Mean;
+  return (x > y) - (x < y);
+}
+
+// Merge the centroids, the buffer and n more centroids into new centroids
+// no larger than the arcsine scale allows, 2 pi / d sqrt(q (1 - q)) of the
+// values at quantile q, nor the logistic scale, q (1 - q) Z / d with
+// Z = 4 ln(n / d) + 24; the second bounds the tails, so the last values at
+// either end stay on their own
+static void td_compress(TDIGEST *t, const TD_CENTROID *more, int n,
+                        double more_total)
+{
+  TD_CENTROID all[TD_CAP + TD_BUF + TD_CAP];
+  TD_CENTROID cur;       // Centroid being built
+  double   scale;        // Z / d
+  double   q0 = 0.0;     // Quantile at the start of cur
+  double   q1;           // Quantile at its end if the next one joins
+  double   w;            // Its weight then
+  double   q;            // q (1 - q) at the more extreme end
+  int      m;
+  int      i;
+
+  memcpy(all, t->C, t->Count * sizeof(TD_CENTROID));
+  m = t->Count;
+  for (i = 0; i < t->Buffered; i++, m++)
+  {
+    all[m].Mean = t->Buf[i];
+    all[m].Weight = 1.0;
+  }
+  memcpy(all + m, more, n * sizeof(TD_CENTROID));
+  m += n;
+  t->Total += more_total;
+  t->Buffered = 0;
+  t->Count = 0;
+  if (m == 0)
+    return;
+  qsort(all, m, sizeof(TD_CENTROID), cmp_centroid);
+
+  scale = (4.0 * log(fmax(t->Total / TD_DELTA, 1.0)) + 24.0) / TD_DELTA;
+  cur = all[0];
+  for (i = 1; i < m; i++)
+  {
+    w = cur.Weight + all[i].Weight;
+    q1 = q0 + w / t->Total;
+    q = fmin(q0 * (1.0 - q0), q1 * (1.0 - q1));
+    if ((w <= t->Total * fmin(scale * q, 2.0 * M_PI / TD_DELTA * sqrt(q))) ||
+        (t->Count == TD_CAP - 1))
+    {
+      cur.Weight = w;
+      cur.Mean += (all[i].Mean - cur.Mean) * all[i].Weight / w;
+      continue;
+    }
+    t->C[t->Count++] = cur;
+    q0 += cur.Weight / t->Total;
+    cur = all[i];
+  }
+  t->C[t->Count++] = cur;
+}
+
+void td_reset(TDIGEST *t)
+{
+  t->Total = 0.0;
+  t->Min = HUGE_VAL;
+  t->Max = -HUGE_VAL;
+  t->Count = 0;
+  t->Buffered = 0;
+}
+
+void td_add(TDIGEST *t, double x)
+{
+  if (t->Buffered == TD_BUF)
+    td_compress(t, NULL, 0, 0.0);
+  t->Buf[t->Buffered++] = x;
+  t->Total += 1.0;
+  t->Min = fmin(t->Min, x);
+  t->Max = fmax(t->Max, x);
+}
+
+void td_merge(TDIGEST *t, const TDIGEST *from)
+{
+  int      i;
+
+  for (i = 0; i < from->Buffered; i++)
+    td_add(t, from->Buf[i]);
+  td_compress(t, from->C, from->Count, from->Total - from->Buffered);
+  t->Min = fmin(t->Min, from->Min);
+  t->Max = fmax(t->Max, from->Max);
+}
+
+double td_quantile(TDIGEST *t, double p)
+{
+  double   target;       // Rank of the quantile
+  double   left;         // Rank of the middle of centroid i - 1
+  double   right;        // Rank of the middle of centroid i
+  double   seen = 0.0;   // Weight before centroid i
+  int      i;
+
+  if (t->Buffered > 0)
+    td_compress(t, NULL, 0, 0.0);
+  if (t->Count == 0)
+    return 0.0;
+
+  // Interpolate between centroid middles, and out to Min and Max at the ends
+  target = p * t->Total;
+  left = 0.0;
+  for (i = 0; i < t->Count; i++)
+  {
+    right = seen + 0.5 * t->C[i].Weight;
+    if (target < right)
+    {
+      if (i == 0)
+        return t->Min + (t->C[0].Mean - t->Min) *
+          ((right > 0.0) ? target / right : 0.0);
+      return t->C[i - 1].Mean + (t->C[i].Mean - t->C[i - 1].Mean) *
+        (target - left) / (right - left);
+    }
+    seen += t->C[i].Weight;
+    left = right;
+  }
+  if (t->Total <= left)
+    return t->Max;
+  return t->C[t->Count - 1].Mean + (t->Max - t->C[t->Count - 1].Mean) *
+    (target - left) / (t->Total - left);
+}
+
+//=============================================================================
+//==  Student-t cdf for integer df by the finite series of Abramowitz and    ==
+//==  Stegun 26.7.3 (odd df) and 26.7.4 (even df)                            ==
+//=============================================================================
+static double t_cdf(double t, long df)
+{
+  double theta = atan(fabs(t) / sqrt((double)df));
+  double c2 = cos(theta) * cos(theta);
+  double term, sum, a;
+  long   k;
+
+  if (df % 2 == 1)
+  {
+    sum = 0.0;
+    if (df > 1)
+    {
+      term = cos(theta);
+      sum = term;
+      for (k = 3; k <= df - 2; k += 2)
+      {
+        term *= c2 * (k - 1) / k;
+        sum += term;
+      }
+    }
+    a = (2.0 / M_PI) * (theta + sin(theta) * sum);
+  }
+  else
+  {
+    term = 1.0;
+    sum = 1.0;
+    for (k = 2; k <= df - 2; k += 2)
+    {
+      term *= c2 * (k - 1) / k;
+      sum += term;
+    }
+    a = sin(theta) * sum;
+  }
+
+  // a is P(|T| < |t|)
+  return (t >= 0.0) ? 0.5 + 0.5 * a : 0.5 - 0.5 * a;
+}
+
+double t_quantile(double p, long df)
+{
+  double z, z2, g1, g2, g3, g4, n, t, f;
+  int    i;
+
+  if (df < 1)
+    return HUGE_VAL;
+  if (df == 1)
+    return tan(M_PI * (p - 0.5));
+  if (df == 2)
+    return (2.0 * p - 1.0) / sqrt(2.0 * p * (1.0 - p));
+
+  // Cornish-Fisher expansion (Abramowitz and Stegun 26.7.5)
+  z = normal_quantile(p);
+  z2 = z * z;
+  n = (double)df;
+  g1 = (z2 + 1.0) * z / 4.0;
+  g2 = ((5.0 * z2 + 16.0) * z2 + 3.0) * z / 96.0;
+  g3 = (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) * z / 384.0;
+  g4 = ((((79.0 * z2 + 776.0) * z2 + 1482.0) * z2 - 1920.0) * z2 - 945.0) * z
+       / 92160.0;
+  t = z + g1 / n + g2 / (n * n) + g3 / (n * n * n) + g4 / (n * n * n * n);
+  if (df > T_EXPANSION_DF)
+    return t;
+
+  // Newton steps on the exact cdf clean up the expansion at small df
+  for (i = 0; i < 3; i++)
+  {
+    f = exp(lgamma(0.5 * (n + 1.0)) - lgamma(0.5 * n) - 0.5 * log(n * M_PI)
+            - 0.5 * (n + 1.0) * log1p(t * t / n));
+    t -= (t_cdf(t, df) - p) / f;
+  }
+  return t;
+}
@@ -0,0 +1,249 @@
+//================================================= file = StatsInterface.h ===
+//=  Output analysis for the CSIM models                                      =
+//=============================================================================
+//=  Notes:                                                                   =
+//=   1) STATS accumulates a sample with Welford's update, so long runs do not=
+//=      lose the variance to cancellation                                    =
+//=   2) stats_half_width() is the Student-t confidence interval half-width   =
+//=      for the mean of independent observations (replications, antithetic   =
+//=      pair averages, batch means)                                          =
+//=   3) t_quantile() is exact for 1 and 2 degrees of freedom, otherwise the  =
+//=      Cornish-Fisher expansion about the normal quantile, polished by      =
+//=      Newton steps on the exact cdf up to 30 df (error below 1e-9)         =
+//=   4) CV_STATS is the control-variate estimator for the mean of y given    =
+//=      controls c[0..Q-1] with known means Mu: y - beta'(cbar - Mu), beta   =
+//=      the least-squares slope of y on c, with the CI of Lavenberg and      =
+//=      Welch (n - Q - 1 df).  Each observation must be independent (a       =
+//=      replication or a group average).  See S. Lavenberg and P. Welch,     =
+//=      "A Perspective on the Use of Control Variables to Increase the       =
+//=      Efficiency of Monte Carlo Simulations," Management Sci., 1981        =
+//=   5) chi2_sf() and ks_sf() are upper-tail p-values for goodness-of-fit    =
+//=      tests (the regularized incomplete gamma function; Kolmogorov's       =
+//=      limit with Stephens' small-sample correction)                        =
+//=   6) MSER is the MSER-5 warm-up detector: observations are averaged in    =
+//=      batches of MSER_BATCH and the truncation d minimizes the variance    =
+//=      of the mean of the batches after d, over d up to half of them.  At   =
+//=      MSER_MAX batches adjacent pairs are merged (batches of 10, 20, ...)  =
+//=      so memory stays bounded on any run length.  See K. White, "An        =
+//=      Effective Truncation Heuristic for Bias Reduction in Simulation      =
+//=      Output," Simulation, 1997                                            =
+//=   7) RATIO_STATS is the ratio estimator sum(y) / sum(x) of i.i.d. pairs,  =
+//=      e.g. regeneration cycles (y the cycle's total, x its length or       =
+//=      count), with the CI from the variance of y - r x (delta method)      =
+//=   8) HDR is a log-linear histogram in fixed memory: each power of two     =
+//=      from 2^HDR_MIN_EXP to 2^HDR_MAX_EXP is cut into 2^HDR_SUB_BITS       =
+//=      equal buckets, so a bucket's midpoint is within 2^-(HDR_SUB_BITS+1)  =
+//=      (0.4%) of any value in it.  hdr_record() takes the bucket straight   =
+//=      from the bits of the double (no search, no known range needed);      =
+//=      values below the range share the first bucket and values above it    =
+//=      the last.  Histograms add, so replications or batches merge.  See    =
+//=      G. Tene, HdrHistogram (hdrhistogram.org)                             =
+//=   9) TDIGEST is a merging t-digest quantile sketch: values gather in a    =
+//=      buffer of TD_BUF and are then merged, in order, into at most         =
+//=      TD_CAP centroids whose sizes the arcsine and logistic scale          =
+//=      functions limit (TD_DELTA), so they are smallest at the tails and    =
+//=      p99 or p99.9 keep a small error on any number of values (the         =
+//=      extremes are exact).  td_merge() combines two digests the same       =
+//=      way; a digest is a fixed-size struct with no pointers, so it can be  =
+//=      copied between processes (shared memory, a pipe, ckpt_save) as is.   =
+//=      See T. Dunning and O. Ertl, "Computing Extremely Accurate Quantiles  =
+//=      Using t-Digests," arXiv:1902.04023, 2019                             =
+//=============================================================================
+#ifndef _STATS_INTERFACE_H
+#define _STATS_INTERFACE_H
+
+#include <stdint.h>
+
+#ifndef Stats_Has_Been_Defined
+   typedef struct {
+     long   N;        // Number of observations
+     double Mean;     // Running mean
+     double M2;       // Running sum of squared deviations from the mean
+   } STATS;
+#define Stats_Has_Been_Defined
+#endif
+
+#define CV_MAX 4        // Most control variates
+
+#ifndef CV_Stats_Has_Been_Defined
+   typedef struct {
+     int    Q;                  // Number of controls
+     long   N;                  // Number of observations
+     double Mu[CV_MAX];         // Known means of the controls
+     double Mean[CV_MAX + 1];   // Running means of (y, c[0..Q-1])
+     double M2[CV_MAX + 1][CV_MAX + 1]; // Running co-moments about the means
+   } CV_STATS;
+#define CV_Stats_Has_Been_Defined
+#endif
+
+#ifndef Ratio_Stats_Has_Been_Defined
+   typedef struct {
+     long   N;        // Number of pairs
+     double MeanY;    // Running means
+     double MeanX;
+     double Syy;      // Running co-moments about the means
+     double Sxy;
+     double Sxx;
+   } RATIO_STATS;
+#define Ratio_Stats_Has_Been_Defined
+#endif
+
+#define MSER_BATCH 5    // Observations per batch (MSER-5)
+#define MSER_MAX   256  // Most batches kept (even)
+#define MSER_MIN   20   // Fewest batches before a truncation is reported
+
+#ifndef Mser_Has_Been_Defined
+   typedef struct {
+     long   N;                  // Number of observations
+     long   Size;               // Observations per kept batch
+     int    Count;              // Batches kept
+     long   Fill;               // Observations in the open batch
+     double Sum;                // Their sum
+     double Batch[MSER_MAX];    // Batch means, oldest first
+   } MSER;
+#define Mser_Has_Been_Defined
+#endif
+
+#define HDR_SUB_BITS 7  // log2 of the buckets per power of two
+#define HDR_MIN_EXP  -20 // Smallest power of two resolved (about 1e-6)
+#define HDR_MAX_EXP  20 // Largest power of two resolved (about 1e6)
+#define HDR_BINS ((HDR_MAX_EXP - HDR_MIN_EXP) << HDR_SUB_BITS)
+#define HDR_BASE ((int64_t) (1023 + HDR_MIN_EXP) << HDR_SUB_BITS)
+
+#ifndef Hdr_Has_Been_Defined
+   typedef struct {
+     long   N;                  // Number of values
+     long   Count[HDR_BINS];    // Values in each bucket
+   } HDR;
+#define Hdr_Has_Been_Defined
+#endif
+
+#define TD_DELTA 100    // t-digest compression (more = larger, more accurate)
+#define TD_CAP   (2 * TD_DELTA) // Most centroids (about TD_DELTA are used)
+#define TD_BUF   500    // Values buffered between merges
+
+#ifndef TDigest_Has_Been_Defined
+   typedef struct {
+     double Mean;               // Mean of the values in the centroid
+     double Weight;             // Number of them
+   } TD_CENTROID;
+
+   typedef struct {
+     double Total;              // Number of values (merged and buffered)
+     double Min;                // Smallest and largest values
+     double Max;
+     int    Count;              // Centroids, in increasing Mean
+     int    Buffered;           // Values waiting in Buf
+     TD_CENTROID C[TD_CAP];
+     double Buf[TD_BUF];
+   } TDIGEST;
+#define TDigest_Has_Been_Defined
+#endif
+
+// defined operations
+extern void stats_reset(STATS *st);
+// Empty the sample
+
+extern void stats_add(STATS *st, double x);
+// Add one observation
+
+extern double stats_mean(const STATS *st);
+// Sample mean (0 if empty)
+
+extern double stats_var(const STATS *st);
+// Sample variance (0 with fewer than two observations)
+
+extern double stats_half_width(const STATS *st, double level);
+// Half-width of the level (e.g. 0.95) confidence interval for the mean
+
+extern void cv_reset(CV_STATS *cv, int q, const double *mu);
+// Empty the sample and set q controls with known means mu[0..q-1]
+
+extern void cv_add(CV_STATS *cv, double y, const double *c);
+// Add one observation of y with its controls c[0..Q-1]
+
+extern void cv_raw(const CV_STATS *cv, STATS *st);
+// Copy the sample of y alone into st, for the unadjusted mean and CI
+
+extern int cv_beta(const CV_STATS *cv, double *beta);
+// Control coefficients beta[0..Q-1]; -1 if fewer than Q + 3 observations
+// or the controls are collinear (e.g. one is constant)
+
+extern double cv_mean(const CV_STATS *cv);
+// Control-variate estimate of the mean of y (the raw mean if cv_beta fails)
+
+extern double cv_half_width(const CV_STATS *cv, double level);
+// Half-width of the level confidence interval for cv_mean()
+
+extern double chi2_sf(double x, long df);
+// P(X > x) for X chi-square with df degrees of freedom
+
+extern double ks_sf(double d, long n);
+// P(D > d) for the Kolmogorov-Smirnov statistic D of n observations
+
+extern void ratio_reset(RATIO_STATS *r);
+// Empty the sample
+
+extern void ratio_add(RATIO_STATS *r, double y, double x);
+// Add one pair
+
+extern double ratio_mean(const RATIO_STATS *r);
+// Ratio estimate sum(y) / sum(x) (0 if empty)
+
+extern double ratio_half_width(const RATIO_STATS *r, double level);
+// Half-width of the level confidence interval for the ratio
+
+extern void mser_reset(MSER *m);
+// Empty the detector
+
+extern int mser_add(MSER *m, double x);
+// Add one observation; 1 if it closed a batch
+
+extern long mser_truncation(const MSER *m);
+// Observations to discard as warm-up; -1 while the minimum is still in the
+// second half of the batches (not warm yet) or there are too few of them
+
+extern void hdr_reset(HDR *h);
+// Empty the histogram
+
+extern void hdr_merge(HDR *h, const HDR *from);
+// Add the values of from to h
+
+extern double hdr_percentile(const HDR *h, double p);
+// Midpoint of the bucket holding the p-quantile (p in (0,1]; 0 if empty)
+
+extern void td_reset(TDIGEST *t);
+// Empty the digest
+
+extern void td_add(TDIGEST *t, double x);
+// Add one value
+
+extern void td_merge(TDIGEST *t, const TDIGEST *from);
+// Add the values summarized by from to t
+
+extern double td_quantile(TDIGEST *t, double p);
+// Estimate of the p-quantile (p in [0,1]; 0 if empty); merges the buffer
+
+extern double normal_quantile(double p);
+// Inverse of the standard normal cdf for p in (0,1)
+
+extern double t_quantile(double p, long df);
+// Inverse of the Student-t cdf with df degrees of freedom for p in (0,1)
+
+//----- Inline recording ------------------------------------------------------
+// Add one value x >= 0: the exponent and top HDR_SUB_BITS mantissa bits of a
+// positive double are its bucket, offset by HDR_BASE and clamped
+static inline void hdr_record(HDR *h, double x)
+{
+  union { double d; int64_t i; } v;
+  int64_t  k;
+
+  v.d = (x > 0.0) ? x : 0.0;
+  k = (v.i >> (52 - HDR_SUB_BITS)) - HDR_BASE;
+  k = (k < 0) ? 0 : k;
+  k = (k >= HDR_BINS) ? HDR_BINS - 1 : k;
+  h->Count[k]++;
+  h->N++;
+}
+
+#endif
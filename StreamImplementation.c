@@ -0,0 +1,402 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "StreamInterface.h"
+
+//----- Philox4x32-10 constants -----------------------------------------------
+#define PHILOX_M0 0xD2511F53u   // Round multiplier for words 0/1
+#define PHILOX_M1 0xCD9E8D57u   // Round multiplier for words 2/3
+#define PHILOX_W0 0x9E3779B9u   // Key schedule bump (golden ratio)
+#define PHILOX_W1 0xBB67AE85u   // Key schedule bump (sqrt(3) - 1)
+#define PHILOX_ROUNDS 10
+
+#define FILL_LANES 8            // Counters computed side by side in a fill
+#define SOBOL_BITS 32           // Bits per Sobol coordinate
+
+// Map the top 52 of 64 bits to (0,1); the half-ulp offset keeps 0 and 1 out
+#define TO_UNIT(hi, lo) \
+  (((double)(((uint64_t)(hi) << 20) | ((lo) >> 12)) + 0.5) * (1.0 / 4503599627370496.0))
+
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4])
+{
+  uint32_t x0 = ctr[0], x1 = ctr[1], x2 = ctr[2], x3 = ctr[3];
+  uint32_t k0 = key[0], k1 = key[1];
+  uint64_t p0, p1;
+  int      r;
+
+  for (r = 0; r < PHILOX_ROUNDS; r++)
+  {
+    p0 = (uint64_t)PHILOX_M0 * x0;
+    p1 = (uint64_t)PHILOX_M1 * x2;
+    x0 = (uint32_t)(p1 >> 32) ^ x1 ^ k0;
+    x1 = (uint32_t)p1;
+    x2 = (uint32_t)(p0 >> 32) ^ x3 ^ k1;
+    x3 = (uint32_t)p0;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+
+  out[0] = x0;
+  out[1] = x1;
+  out[2] = x2;
+  out[3] = x3;
+}
+
+//=============================================================================
+//==  Compute FILL_LANES consecutive blocks as a structure of arrays so the  ==
+//==  compiler can keep each round in vector registers                       ==
+//=============================================================================
+static void philox_lanes(uint64_t block, const PHILOX *s,
+                         uint32_t out[4][FILL_LANES])
+{
+  uint32_t x0[FILL_LANES], x1[FILL_LANES], x2[FILL_LANES], x3[FILL_LANES];
+  uint32_t k0 = s->Key[0], k1 = s->Key[1];
+  uint64_t p0, p1;
+  uint32_t t;
+  int      r, j;
+
+  for (j = 0; j < FILL_LANES; j++)
+  {
+    x0[j] = (uint32_t)(block + j);
+    x1[j] = (uint32_t)((block + j) >> 32);
+    x2[j] = s->Ctr[2];
+    x3[j] = s->Ctr[3];
+  }
+
+  for (r = 0; r < PHILOX_ROUNDS; r++)
+  {
+    for (j = 0; j < FILL_LANES; j++)
+    {
+      p0 = (uint64_t)PHILOX_M0 * x0[j];
+      p1 = (uint64_t)PHILOX_M1 * x2[j];
+      t = x1[j];
+      x0[j] = (uint32_t)(p1 >> 32) ^ t ^ k0;
+      x1[j] = (uint32_t)p1;
+      x2[j] = (uint32_t)(p0 >> 32) ^ x3[j] ^ k1;
+      x3[j] = (uint32_t)p0;
+    }
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+
+  for (j = 0; j < FILL_LANES; j++)
+  {
+    out[0][j] = x0[j] ^ s->Flip;
+    out[1][j] = x1[j] ^ s->Flip;
+    out[2][j] = x2[j] ^ s->Flip;
+    out[3][j] = x3[j] ^ s->Flip;
+  }
+}
+
+static uint64_t get_block(PSTREAM s)
+{
+  return ((uint64_t)s->Ctr[1] << 32) | s->Ctr[0];
+}
+
+static void set_block(PSTREAM s, uint64_t block)
+{
+  s->Ctr[0] = (uint32_t)block;
+  s->Ctr[1] = (uint32_t)(block >> 32);
+}
+
+static void load_buf(PSTREAM s)
+{
+  philox4x32(s->Ctr, s->Key, s->Buf);
+  s->Buf[0] ^= s->Flip;
+  s->Buf[1] ^= s->Flip;
+  s->Buf[2] ^= s->Flip;
+  s->Buf[3] ^= s->Flip;
+}
+
+PSTREAM create_pstream(long seed, long replication, long component)
+{
+  PSTREAM s;
+
+  s = (PSTREAM) malloc(sizeof(PHILOX));
+  if (s == NULL)
+  {
+    fprintf(stderr, "system storage is exhausted");
+    return NULL;
+  }
+  init_pstream(s, seed, replication, component);
+
+  return s;
+}
+
+void init_pstream(PSTREAM s, long seed, long replication, long component)
+{
+  reseed_pstream(s, seed, replication, component);
+}
+
+void reseed_pstream(PSTREAM s, long seed, long replication, long component)
+{
+  s->Key[0] = (uint32_t)seed;
+  s->Key[1] = (uint32_t)((uint64_t)seed >> 32);
+  s->Ctr[0] = 0;
+  s->Ctr[1] = 0;
+  s->Ctr[2] = (uint32_t)component;
+  s->Ctr[3] = (uint32_t)replication;
+  s->Used = 4;
+  s->Flip = 0;
+}
+
+void delete_pstream(PSTREAM s)
+{
+  free(s);
+}
+
+uint64_t pstream_tell(PSTREAM s)
+{
+  // Ctr[0..1] names the next block to compute; Buf holds the one before it
+  if (s->Used == 4)
+    return 4 * get_block(s);
+  return 4 * (get_block(s) - 1) + s->Used;
+}
+
+void pstream_seek(PSTREAM s, uint64_t words)
+{
+  set_block(s, words / 4);
+  s->Used = 4;
+  if (words % 4 != 0)
+  {
+    load_buf(s);
+    set_block(s, words / 4 + 1);
+    s->Used = (int)(words % 4);
+  }
+}
+
+uint32_t pstream_next32(PSTREAM s)
+{
+  if (s->Used == 4)
+  {
+    load_buf(s);
+    set_block(s, get_block(s) + 1);
+    s->Used = 0;
+  }
+  return s->Buf[s->Used++];
+}
+
+double pstream_uniform01(PSTREAM s)
+{
+  uint32_t hi = pstream_next32(s);
+  uint32_t lo = pstream_next32(s);
+
+  return TO_UNIT(hi, lo);
+}
+
+double pstream_uniform(PSTREAM s, double mn, double mx)
+{
+  return mn + (mx - mn) * pstream_uniform01(s);
+}
+
+void pstream_fill_uniform01(PSTREAM s, double *u, long n)
+{
+  uint32_t out[4][FILL_LANES];
+  uint32_t carry;
+  uint64_t block;
+  long     i = 0;
+  int      j;
+
+  // Drain a partly used block to its end, or to its last word if Used is odd
+  while (i < n && s->Used != 4 && s->Used != 3)
+    u[i++] = pstream_uniform01(s);
+
+  // Each block yields two uniforms; from an odd word they straddle blocks
+  // as (carry, w0), (w1, w2), with w3 carried on
+  if (n - i >= 2 * FILL_LANES)
+  {
+    carry = s->Buf[3];
+    block = get_block(s);
+    while (n - i >= 2 * FILL_LANES)
+    {
+      philox_lanes(block, s, out);
+      if (s->Used == 3)
+      {
+        for (j = 0; j < FILL_LANES; j++)
+        {
+          u[i + 2 * j]     = TO_UNIT(carry, out[0][j]);
+          u[i + 2 * j + 1] = TO_UNIT(out[1][j], out[2][j]);
+          carry = out[3][j];
+        }
+      }
+      else
+      {
+        for (j = 0; j < FILL_LANES; j++)
+        {
+          u[i + 2 * j]     = TO_UNIT(out[0][j], out[1][j]);
+          u[i + 2 * j + 1] = TO_UNIT(out[2][j], out[3][j]);
+        }
+      }
+      block += FILL_LANES;
+      i += 2 * FILL_LANES;
+    }
+    set_block(s, block);
+    s->Buf[3] = carry;    // Only word 3 of the block before is still unused
+  }
+
+  while (i < n)
+    u[i++] = pstream_uniform01(s);
+}
+
+void pstream_fill64(PSTREAM s, uint64_t *w, long n)
+{
+  uint32_t out[4][FILL_LANES];
+  uint32_t carry;
+  uint64_t block;
+  long     i = 0;
+  int      j;
+
+  while (i < n && s->Used != 4 && s->Used != 3)
+  {
+    w[i] = (uint64_t)pstream_next32(s) << 32;
+    w[i] = w[i] | pstream_next32(s);
+    i++;
+  }
+
+  if (n - i >= 2 * FILL_LANES)
+  {
+    carry = s->Buf[3];
+    block = get_block(s);
+    while (n - i >= 2 * FILL_LANES)
+    {
+      philox_lanes(block, s, out);
+      if (s->Used == 3)
+      {
+        for (j = 0; j < FILL_LANES; j++)
+        {
+          w[i + 2 * j]     = ((uint64_t)carry << 32) | out[0][j];
+          w[i + 2 * j + 1] = ((uint64_t)out[1][j] << 32) | out[2][j];
+          carry = out[3][j];
+        }
+      }
+      else
+      {
+        for (j = 0; j < FILL_LANES; j++)
+        {
+          w[i + 2 * j]     = ((uint64_t)out[0][j] << 32) | out[1][j];
+          w[i + 2 * j + 1] = ((uint64_t)out[2][j] << 32) | out[3][j];
+        }
+      }
+      block += FILL_LANES;
+      i += 2 * FILL_LANES;
+    }
+    set_block(s, block);
+    s->Buf[3] = carry;
+  }
+
+  while (i < n)
+  {
+    w[i] = (uint64_t)pstream_next32(s) << 32;
+    w[i] = w[i] | pstream_next32(s);
+    i++;
+  }
+}
+
+void pstream_antithetic(PSTREAM s, int on)
+{
+  uint32_t flip = on ? 0xFFFFFFFFu : 0;
+
+  // Words already in Buf were made with the old mask
+  if (s->Used != 4 && flip != s->Flip)
+  {
+    s->Buf[0] ^= 0xFFFFFFFFu;
+    s->Buf[1] ^= 0xFFFFFFFFu;
+    s->Buf[2] ^= 0xFFFFFFFFu;
+    s->Buf[3] ^= 0xFFFFFFFFu;
+  }
+  s->Flip = flip;
+}
+
+//=============================================================================
+//==  Sobol' sequence (Joe-Kuo direction numbers, Gray code order)           ==
+//=============================================================================
+static const struct {       // Degree, interior coefficients, initial m_k
+  int      S;
+  int      A;
+  uint32_t M[7];
+} Sobol_jk[SOBOL_MAXDIM - 1] = {
+  {1,  0, {1}},                         {2,  1, {1, 3}},
+  {3,  1, {1, 3, 1}},                   {3,  2, {1, 1, 1}},
+  {4,  1, {1, 1, 3, 3}},                {4,  4, {1, 3, 5, 13}},
+  {5,  2, {1, 1, 5, 5, 17}},            {5,  4, {1, 1, 5, 5, 5}},
+  {5,  7, {1, 1, 7, 11, 19}},           {5, 11, {1, 1, 5, 1, 1}},
+  {5, 13, {1, 1, 1, 3, 11}},            {5, 14, {1, 3, 5, 5, 31}},
+  {6,  1, {1, 3, 3, 9, 7, 49}},         {6, 13, {1, 1, 1, 15, 21, 21}},
+  {6, 16, {1, 3, 1, 13, 27, 49}},       {6, 19, {1, 1, 1, 15, 7, 5}},
+  {6, 22, {1, 3, 1, 15, 13, 25}},       {6, 25, {1, 1, 5, 5, 19, 61}},
+  {7,  1, {1, 3, 7, 11, 23, 15, 103}},  {7,  4, {1, 3, 7, 13, 13, 15, 69}},
+  {7,  7, {1, 1, 3, 13, 7, 35, 63}},    {7,  8, {1, 3, 5, 9, 1, 25, 53}},
+  {7, 14, {1, 3, 1, 13, 9, 35, 107}},   {7, 19, {1, 3, 1, 5, 27, 61, 31}},
+  {7, 21, {1, 1, 5, 11, 19, 41, 61}},   {7, 28, {1, 3, 5, 3, 3, 13, 69}},
+  {7, 31, {1, 1, 7, 13, 1, 19, 1}},     {7, 32, {1, 3, 7, 5, 13, 19, 59}}
+};
+
+static uint32_t Sobol_v[SOBOL_MAXDIM][SOBOL_BITS];  // Direction numbers
+static int      Sobol_ready = 0;
+
+static void setup_sobol(void)
+{
+  int i, j, k, s, a;
+
+  // The first dimension is the van der Corput sequence
+  for (k = 0; k < SOBOL_BITS; k++)
+    Sobol_v[0][k] = 1u << (SOBOL_BITS - 1 - k);
+
+  for (j = 1; j < SOBOL_MAXDIM; j++)
+  {
+    s = Sobol_jk[j - 1].S;
+    a = Sobol_jk[j - 1].A;
+    for (k = 0; k < s; k++)
+      Sobol_v[j][k] = Sobol_jk[j - 1].M[k] << (SOBOL_BITS - 1 - k);
+    for (k = s; k < SOBOL_BITS; k++)
+    {
+      Sobol_v[j][k] = Sobol_v[j][k - s] ^ (Sobol_v[j][k - s] >> s);
+      for (i = 1; i < s; i++)
+        if ((a >> (s - 1 - i)) & 1)
+          Sobol_v[j][k] ^= Sobol_v[j][k - i];
+    }
+  }
+  Sobol_ready = 1;
+}
+
+int init_sobol(SOBOL *q, int dim, PSTREAM shift)
+{
+  int j;
+
+  if (dim < 1 || dim > SOBOL_MAXDIM)
+  {
+    fprintf(stderr, "Sobol dimension %d is not in 1..%d", dim, SOBOL_MAXDIM);
+    return -1;
+  }
+  if (!Sobol_ready)
+    setup_sobol();
+
+  q->Dim = dim;
+  q->Index = 0;
+  for (j = 0; j < dim; j++)
+  {
+    q->X[j] = 0;
+    q->Shift[j] = (shift == NULL) ? 0 : pstream_next32(shift);
+  }
+
+  return 0;
+}
+
+void sobol_next(SOBOL *q, double *u)
+{
+  uint32_t i = q->Index;
+  int      c = 0;
+  int      j;
+
+  for (j = 0; j < q->Dim; j++)
+    u[j] = ((double)(q->X[j] ^ q->Shift[j]) + 0.5) * (1.0 / 4294967296.0);
+
+  // Gray code: the next point differs in the lowest zero bit of Index
+  while (i & 1)
+  {
+    i >>= 1;
+    c++;
+  }
+  for (j = 0; j < q->Dim; j++)
+    q->X[j] ^= Sobol_v[j][c];
+  q->Index++;
+}
@@ -0,0 +1,97 @@
+//================================================ file = StreamInterface.h ===
+//=  Counter-based random number streams (Philox4x32-10)                      =
+//=============================================================================
+//=  Notes:                                                                   =
+//=   1) Mirrors the csim.h STREAM calls (create_stream, reseed,              =
+//=      stream_uniform01) with a "pstream" prefix so both can coexist        =
+//=   2) A stream is (seed, replication, component); every such triple is an  =
+//=      independent substream of 2^64 blocks, so replications and model      =
+//=      components never share random numbers and need no coordination      =
+//=   3) The state is just a counter, so jumping ahead is O(1)                =
+//=   4) See J. Salmon, M. Moraes, R. Dror and D. Shaw, "Parallel Random      =
+//=      Numbers: As Easy as 1, 2, 3," SC'11, November 2011.                  =
+//=   5) pstream_antithetic() complements every output word, so each          =
+//=      pstream_uniform01() value u becomes exactly 1 - u                    =
+//=   6) SOBOL is a Sobol' sequence with a random digital shift, using the    =
+//=      direction numbers of S. Joe and F. Kuo, "Constructing Sobol          =
+//=      Sequences with Better Two-Dimensional Projections," SIAM J. Sci.     =
+//=      Comput., 2008 (new-joe-kuo-6, first SOBOL_MAXDIM dimensions)         =
+//=============================================================================
+#ifndef _STREAM_INTERFACE_H
+#define _STREAM_INTERFACE_H
+
+#include <stdint.h>
+
+#ifndef PStream_Has_Been_Defined
+   typedef struct {
+     uint32_t Key[2];   // Philox key (the seed)
+     uint32_t Ctr[4];   // Ctr[0..1] block, Ctr[2] component, Ctr[3] replication
+     uint32_t Buf[4];   // Output block for the current counter
+     int      Used;     // Words of Buf already handed out (4 = refill)
+     uint32_t Flip;     // XORed into every word (~0 for antithetic)
+   } PHILOX;
+   typedef PHILOX *PSTREAM;
+#define PStream_Has_Been_Defined
+#endif
+
+#define SOBOL_MAXDIM 29   // Dimensions with direction numbers
+
+#ifndef Sobol_Has_Been_Defined
+   typedef struct {
+     int      Dim;                  // Dimensions in use
+     uint32_t Index;                // Points generated so far
+     uint32_t X[SOBOL_MAXDIM];      // Next point, before the shift
+     uint32_t Shift[SOBOL_MAXDIM];  // Random digital shift
+   } SOBOL;
+#define Sobol_Has_Been_Defined
+#endif
+
+// defined operations
+extern void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+// One Philox4x32-10 block: out = bijection of ctr under key
+
+extern PSTREAM create_pstream(long seed, long replication, long component);
+// Allocate a stream positioned at the start of its substream
+
+extern void init_pstream(PSTREAM s, long seed, long replication, long component);
+// Same as create_pstream for a caller-owned PHILOX
+
+extern void reseed_pstream(PSTREAM s, long seed, long replication, long component);
+// Move s to the start of another substream
+
+extern void delete_pstream(PSTREAM s);
+// Free a stream from create_pstream
+
+extern uint64_t pstream_tell(PSTREAM s);
+// Number of 32-bit words consumed from the substream so far
+
+extern void pstream_seek(PSTREAM s, uint64_t words);
+// Jump to word position words of the substream in O(1)
+
+extern uint32_t pstream_next32(PSTREAM s);
+// Next 32 random bits
+
+extern double pstream_uniform01(PSTREAM s);
+// Uniform(0,1) with 52-bit resolution, never exactly 0.0 or 1.0
+
+extern double pstream_uniform(PSTREAM s, double mn, double mx);
+// Uniform(mn,mx)
+
+extern void pstream_fill_uniform01(PSTREAM s, double *u, long n);
+// Fill u[0..n-1] with the next n pstream_uniform01() values in one pass
+
+extern void pstream_fill64(PSTREAM s, uint64_t *w, long n);
+// Fill w[0..n-1] with the next 2n words, paired high word first
+
+extern void pstream_antithetic(PSTREAM s, int on);
+// Complement every word from s from now on (on = 1) or stop (on = 0);
+// seeding turns it off
+
+extern int init_sobol(SOBOL *q, int dim, PSTREAM shift);
+// Start a dim-dimensional sequence, digitally shifted by words from shift
+// (NULL for no shift); returns 0 on success, -1 if dim is out of range
+
+extern void sobol_next(SOBOL *q, double *u);
+// Next point in u[0..Dim-1], each coordinate in (0,1)
+
+#endif
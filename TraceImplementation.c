@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "TraceInterface.h"
+
+int create_trace(const char *name, uint64_t count, TRACE_HEADER *hdr, TRACE *t)
+{
+  size_t offset = (hdr == NULL) ? 0 : TRACE_OFFSET;
+
+  t->Count = count;
+  t->Next = 0;
+  t->Length = offset + count * sizeof(double);
+  t->Fd = open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (t->Fd < 0)
+  {
+    fprintf(stderr, "ERROR in creating trace file (%s) \n", name);
+    return -1;
+  }
+
+  // Size the file up front so the mapping covers every value
+  if (ftruncate(t->Fd, (off_t)t->Length) != 0)
+  {
+    fprintf(stderr, "ERROR in sizing trace file (%s) \n", name);
+    close(t->Fd);
+    return -1;
+  }
+
+  t->Map = mmap(NULL, t->Length, PROT_READ | PROT_WRITE, MAP_SHARED, t->Fd, 0);
+  if (t->Map == MAP_FAILED)
+  {
+    fprintf(stderr, "ERROR in mapping trace file (%s) \n", name);
+    close(t->Fd);
+    return -1;
+  }
+
+  // A NULL header makes a raw file of values only
+  if (hdr != NULL)
+  {
+    memcpy(hdr->Magic, TRACE_MAGIC, sizeof(hdr->Magic));
+    hdr->Count = count;
+    hdr->Offset = TRACE_OFFSET;
+    memcpy(t->Map, hdr, sizeof(TRACE_HEADER));
+  }
+  t->Data = (double *)((char *)t->Map + offset);
+
+  return 0;
+}
+
+int open_trace(const char *name, TRACE *t)
+{
+  const uint16_t     one = 1;
+  const TRACE_HEADER *hdr;
+  struct stat        st;
+  size_t             offset = 0;
+
+  // Values are stored little-endian and used in place
+  if (*(const unsigned char *)&one == 0)
+  {
+    fprintf(stderr, "ERROR trace files need a little-endian host \n");
+    return -1;
+  }
+
+  t->Fd = open(name, O_RDONLY);
+  if (t->Fd < 0)
+  {
+    fprintf(stderr, "ERROR in opening trace file (%s) \n", name);
+    return -1;
+  }
+  if ((fstat(t->Fd, &st) != 0) || (st.st_size < (off_t)sizeof(double)))
+  {
+    fprintf(stderr, "ERROR trace file (%s) is empty \n", name);
+    close(t->Fd);
+    return -1;
+  }
+
+  t->Length = (size_t)st.st_size;
+  t->Map = mmap(NULL, t->Length, PROT_READ, MAP_PRIVATE, t->Fd, 0);
+  if (t->Map == MAP_FAILED)
+  {
+    fprintf(stderr, "ERROR in mapping trace file (%s) \n", name);
+    close(t->Fd);
+    return -1;
+  }
+
+  // Values are consumed front to back exactly once
+  madvise(t->Map, t->Length, MADV_SEQUENTIAL);
+
+  hdr = (const TRACE_HEADER *)t->Map;
+  if ((t->Length >= TRACE_OFFSET) &&
+      (memcmp(hdr->Magic, TRACE_MAGIC, sizeof(hdr->Magic)) == 0))
+  {
+    offset = hdr->Offset;
+    if ((offset < sizeof(TRACE_HEADER)) || (offset % sizeof(double) != 0) ||
+        (offset > t->Length) ||
+        (hdr->Count > (t->Length - offset) / sizeof(double)))
+    {
+      fprintf(stderr, "ERROR trace file (%s) is truncated \n", name);
+      close_trace(t);
+      return -1;
+    }
+    t->Count = hdr->Count;
+  }
+  else
+    t->Count = t->Length / sizeof(double);
+
+  t->Data = (double *)((char *)t->Map + offset);
+  t->Next = 0;
+
+  return 0;
+}
+
+void close_trace(TRACE *t)
+{
+  munmap(t->Map, t->Length);
+  close(t->Fd);
+  t->Map = NULL;
+  t->Data = NULL;
+}
@@ -0,0 +1,66 @@
+//================================================= file = TraceInterface.h ===
+//=  Binary trace files of interarrival or service times                      =
+//=============================================================================
+//=  Notes:                                                                   =
+//=   1) A trace file is a TRACE_HEADER padded to TRACE_OFFSET bytes followed =
+//=      by Count little-endian doubles, so the values start on a page        =
+//=      boundary and can be used straight out of an mmap                     =
+//=   2) genpar2 writes these with -f map; raw files (-f raw) are the same    =
+//=      values with no header, and open_trace() reads either kind            =
+//=============================================================================
+#ifndef _TRACE_INTERFACE_H
+#define _TRACE_INTERFACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRACE_MAGIC  "CSIMTRC1"     // First 8 bytes of every trace file
+#define TRACE_OFFSET 4096           // Byte offset of the first value
+
+#ifndef Trace_Has_Been_Defined
+   typedef struct {
+     char     Magic[8];     // TRACE_MAGIC
+     uint64_t Count;        // Number of values
+     uint64_t Offset;       // Byte offset of the first value
+     uint64_t Seed;         // Generator seed (informational)
+     double   Param[4];     // Generator parameters (informational)
+     char     Desc[64];     // Generator description (informational)
+   } TRACE_HEADER;
+
+   typedef struct {
+     int      Fd;           // File descriptor of the trace
+     void     *Map;         // Whole file as mapped
+     size_t   Length;       // Length of the mapping in bytes
+     double   *Data;        // First value (Map + Offset)
+     uint64_t Count;        // Number of values
+     uint64_t Next;         // Index of the next value for reading
+   } TRACE;
+#define Trace_Has_Been_Defined
+#endif
+
+// defined operations
+extern int create_trace(const char *name, uint64_t count, TRACE_HEADER *hdr,
+                        TRACE *t);
+// Create name sized for count values, write hdr and map the values for
+// writing through t->Data (hdr NULL makes a raw file with no header);
+// returns 0 on success, -1 on error
+
+extern int open_trace(const char *name, TRACE *t);
+// Map name read-only for sequential reading with trace_next(); a file
+// without TRACE_MAGIC is taken as raw doubles; returns 0 on success,
+// -1 on error
+
+static inline int trace_next(TRACE *t, double *x)
+// Next value of the trace, read in place from the mapping; returns 0
+// (leaving x alone) once every value has been read
+{
+  if (t->Next >= t->Count)
+    return 0;
+  *x = t->Data[t->Next++];
+  return 1;
+}
+
+extern void close_trace(TRACE *t);
+// Unmap and close a trace opened by create_trace or open_trace
+
+#endif
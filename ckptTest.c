@@ -0,0 +1,72 @@
+//***************************************************//
+// filename: ckptTest.c
+// Description: An application to test the checkpoint ADT
+//**************************************************//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "StatsInterface.h"
+#include "CheckpointInterface.h"
+
+#define CKPT_FILE "ckptTest.ckp"
+
+typedef struct {
+  long   Next;
+  STATS  Obs;
+  double Half;
+} STATE;
+
+int main()
+{
+  STATE  st;
+  STATE  back;
+  FILE   *fp;
+  int    errors = 0;
+  int    i;
+
+  printf("\n\t\t--- Checkpoint Test ---\n\n");
+
+  ckpt_remove(CKPT_FILE);
+  if (ckpt_load(CKPT_FILE, "run A", &back, sizeof(back)) != 0)
+    errors++;
+
+  memset(&st, 0, sizeof(st));
+  stats_reset(&st.Obs);
+  for (i=0; i<10; i++)
+    stats_add(&st.Obs, i * 0.1);
+  st.Next = 10;
+  st.Half = stats_half_width(&st.Obs, 0.95);
+
+  // Save twice (the second replaces the first) and restore exactly
+  if ((ckpt_save(CKPT_FILE, "run A", &st, sizeof(st)) != 0) ||
+      (ckpt_save(CKPT_FILE, "run A", &st, sizeof(st)) != 0))
+    errors++;
+  memset(&back, 0, sizeof(back));
+  if ((ckpt_load(CKPT_FILE, "run A", &back, sizeof(back)) != 1) ||
+      (memcmp(&back, &st, sizeof(st)) != 0))
+    errors++;
+  printf("Restored: next %ld, mean %f +/- %f\n", back.Next,
+    stats_mean(&back.Obs), back.Half);
+
+  // Another run, another size, or a damaged file are refused
+  printf("Expect three errors:\n");
+  if (ckpt_load(CKPT_FILE, "run B", &back, sizeof(back)) != -1)
+    errors++;
+  if (ckpt_load(CKPT_FILE, "run A", &back, sizeof(back) - 8) != -1)
+    errors++;
+  fp = fopen(CKPT_FILE, "r+b");
+  if (fp != NULL)
+  {
+    fseek(fp, -1, SEEK_END);
+    fputc(0x5a, fp);
+    fclose(fp);
+  }
+  if (ckpt_load(CKPT_FILE, "run A", &back, sizeof(back)) != -1)
+    errors++;
+
+  if (ckpt_remove(CKPT_FILE) != 0)
+    errors++;
+
+  printf("\nErrors: %d\n", errors);
+  return (errors != 0);
+}
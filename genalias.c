@@ -0,0 +1,144 @@
+//=================================================== file = genalias.c =====
+//=  Program to build an empirical (alias table) distribution from a trace  =
+//===========================================================================
+//=  Notes: 1) Input is a trace of times, either a genpar2 -f map file or   =
+//=            raw doubles (see TraceInterface.h)                           =
+//=         2) Output is a table for load_empirical(); the models then      =
+//=            draw from it with dist_sample() in constant time             =
+//=         3) As a check, -c values are drawn from the table and their     =
+//=            mean and CoV are compared with the trace                     =
+//=-------------------------------------------------------------------------=
+//= Example execution:                                                      =
+//=                                                                         =
+//=   genalias -i service.bin -o service.emp                                =
+//=   ---------------------------------------- genalias.c ----              =
+//=   -  Trace service.bin: 10000000 values                                 =
+//=   -  Table service.emp: 4096 bins                                       =
+//=   --------------------------------------------------------              =
+//=   -             mean         CoV                                        =
+//=   -  trace      1.000158     2.5734                                     =
+//=   -  table      1.000170     2.5736  (1000000 draws, 3.1 ns/draw)       =
+//=   --------------------------------------------------------              =
+//=-------------------------------------------------------------------------=
+//=  Build: gcc -O2 genalias.c DistributionImplementation.c                 =
+//=             StreamImplementation.c TraceImplementation.c -lm            =
+//=-------------------------------------------------------------------------=
+//=  Execute: genalias -i trace -o table [-b bins] [-c draws] [-s seed]     =
+//===========================================================================
+//----- Include files -------------------------------------------------------
+#include <stdio.h>            // Needed for printf()
+#include <stdlib.h>           // Needed for exit() and ato*()
+#include <math.h>             // Needed for sqrt()
+#include <time.h>             // Needed for clock_gettime()
+#include <unistd.h>           // Needed for getopt()
+#include "StreamInterface.h"        // Needed for PHILOX
+#include "DistributionInterface.h"  // Needed for build_empirical()
+#include "TraceInterface.h"         // Needed for open_trace()
+
+//----- Function prototypes -------------------------------------------------
+void usage(void);                             // Print the option summary
+void moments(const double *x, long n, double *mean, double *cov);
+
+//===== Main program ========================================================
+int main(int argc, char *argv[])
+{
+  char     *in_name = NULL;   // Input trace name
+  char     *out_name = NULL;  // Output table name
+  int      bins = EMP_BINS;   // Number of bins
+  long     draws = 1000000;   // Number of check draws
+  int      seed = 1;          // Seed for the check draws
+  TRACE    trace;             // Input trace
+  EMP_DIST emp;               // Empirical distribution
+  PHILOX   stream;            // Stream for the check draws
+  double   *x;                // Check draws
+  double   mean, cov;         // Mean and CoV
+  double   secs;              // Time for the check draws
+  struct timespec t0, t1;     // Start and end times
+  long     i;                 // Loop counter
+  int      c;                 // Option character
+
+  while ((c = getopt(argc, argv, "i:o:b:c:s:")) != -1)
+  {
+    switch (c)
+    {
+      case 'i': in_name = optarg; break;
+      case 'o': out_name = optarg; break;
+      case 'b': bins = atoi(optarg); break;
+      case 'c': draws = atol(optarg); break;
+      case 's': seed = atoi(optarg); break;
+      default: usage();
+    }
+  }
+  if ((in_name == NULL) || (out_name == NULL) || (bins < 1) ||
+      (draws < 0) || (seed <= 0))
+    usage();
+
+  // Build the table from the mapped trace and save it
+  if (open_trace(in_name, &trace) != 0)
+    exit(1);
+  if (build_empirical(trace.Data, (long) trace.Count, bins, &emp) != 0)
+    exit(1);
+  if (save_empirical(out_name, &emp) != 0)
+    exit(1);
+
+  printf("---------------------------------------- genalias.c ---- \n");
+  printf("-  Trace %s: %ld values \n", in_name, emp.Count);
+  printf("-  Table %s: %d bins \n", out_name, emp.Bins);
+  printf("-------------------------------------------------------- \n");
+  printf("-             mean         CoV \n");
+  moments(trace.Data, (long) trace.Count, &mean, &cov);
+  printf("-  trace   %10.6f  %10.4f \n", mean, cov);
+  close_trace(&trace);
+
+  // Draw from the table as the models will
+  if (draws > 0)
+  {
+    x = (double *) malloc(draws * sizeof(double));
+    if (x == NULL)
+    {
+      printf("ERROR in allocating %ld check draws \n", draws);
+      exit(1);
+    }
+    init_pstream(&stream, (uint32_t) seed, 0, 0);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i=0; i<draws; i++)
+      x[i] = dist_sample(&emp, &stream);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    secs = (t1.tv_sec - t0.tv_sec) + 1.0e-9 * (t1.tv_nsec - t0.tv_nsec);
+    moments(x, draws, &mean, &cov);
+    printf("-  table   %10.6f  %10.4f  (%ld draws, %.1f ns/draw) \n",
+      mean, cov, draws, 1.0e9 * secs / draws);
+    free(x);
+  }
+  printf("-------------------------------------------------------- \n");
+
+  free_empirical(&emp);
+  return(0);
+}
+
+//===========================================================================
+//=  Function to print the option summary and exit                          =
+//===========================================================================
+void usage(void)
+{
+  fprintf(stderr, "Usage: genalias -i trace -o table [-b bins] [-c draws] \n");
+  fprintf(stderr, "                [-s seed] \n");
+  exit(1);
+}
+
+//===========================================================================
+//=  Function to compute the mean and coefficient of variation of x         =
+//===========================================================================
+void moments(const double *x, long n, double *mean, double *cov)
+{
+  double sum = 0.0;   // Sum of x
+  double ss = 0.0;    // Sum of squared deviations
+  long   i;           // Loop counter
+
+  for (i=0; i<n; i++)
+    sum += x[i];
+  *mean = sum / n;
+  for (i=0; i<n; i++)
+    ss += (x[i] - *mean) * (x[i] - *mean);
+  *cov = (n > 1) ? sqrt(ss / (n - 1)) / *mean : 0.0;
+}
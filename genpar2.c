@@ -9,6 +9,20 @@
 //=         3) See M. Crovella and M. Harchol-Balter, and C. Murta, "Task   =
 //=            Assignment in a Distributed System: Improving Performance    =
 //=            by Unbalancing Load," BUCS-TR-1997-018, October 1997.        =
+//=         4) With no arguments the parameters are prompted for (below);   =
+//=            with arguments it runs unattended (see Execute)              =
+//=         5) Output formats (-f):                                         =
+//=             * text = one value per line, shortest string that reads     =
+//=                      back to the identical double                       =
+//=             * raw  = little-endian doubles, no header                   =
+//=             * map  = trace file (TraceInterface.h) for mmap input       =
+//=         6) -g philox (default) generates in blocks from a Philox        =
+//=            stream via pstream_fill_bpareto(); -g jain reproduces the    =
+//=            original rand_val() sequence for a given seed                =
+//=         7) -g philox splits the values over -t threads (default all     =
+//=            cores); value i always comes from the same point of the      =
+//=            stream, so the file is identical for any number of threads   =
+//=            (-g jain is inherently sequential and runs one thread)       =
 //=-------------------------------------------------------------------------=
 //= Example user input:                                                     =
 //=                                                                         =
@@ -40,9 +54,19 @@
 //=   1.504652                                                              =
 //=   1.659515                                                              =
 //=-------------------------------------------------------------------------=
-//=  Build: bcc32 genpar2.c                                                 =
+//=  Build: gcc -O2 -mavx2 -pthread genpar2.c DistributionImplementation.c  =
+//=             StreamImplementation.c TraceImplementation.c -lm            =
 //=-------------------------------------------------------------------------=
 //=  Execute: genpar2                                                       =
+//=           genpar2 -o out.bin -f raw -s 1 -a 1.5 -k 1 -p 100 -n 1000000  =
+//=             -o file    output file name                                 =
+//=             -f format  text, raw or map (default text)                  =
+//=             -g rng     philox or jain (default philox)                  =
+//=             -s seed    random number seed (default 1)                   =
+//=             -a, -k, -p Pareto alpha, k and p values                     =
+//=             -n num     number of values to generate                     =
+//=             -t threads worker threads (default number of cores)         =
+//=             -q         no banner or summary                             =
 //=-------------------------------------------------------------------------=
 //=  Author: Kenneth J. Christensen                                         =
 //=          University of South Florida                                    =
@@ -58,14 +82,185 @@
 //----- Include files -------------------------------------------------------
 #include <stdio.h>            // Needed for printf()
 #include <stdlib.h>           // Needed for exit() and ato*()
+#include <string.h>           // Needed for strcmp() and memcpy()
+#include <stdint.h>           // Needed for uint64_t
+#include <time.h>             // Needed for clock_gettime()
+#include <unistd.h>           // Needed for getopt() and sysconf()
+#include <pthread.h>          // Needed for pthread_create()
 #include <math.h>             // Needed for log() and pow()
+#include "StreamInterface.h"        // Needed for PHILOX
+#include "DistributionInterface.h"  // Needed for pstream_fill_bpareto()
+#include "TraceInterface.h"         // Needed for create_trace()
+
+//----- Defines -------------------------------------------------------------
+#define BLOCK    65536        // Values generated per block
+#define TEXT_BUF (1 << 20)    // Bytes of text buffered per write
+#define LINE_MAX_LEN 26       // Longest text line (sign, 17 digits, point,
+                              //   exponent and newline)
+#define MAX_THREADS 256       // Most worker threads
+#define FMT_TEXT 0            // Output formats
+#define FMT_RAW  1
+#define FMT_MAP  2
+#define RNG_PHILOX 0          // Generators
+#define RNG_JAIN   1
+
+//----- Type definitions ----------------------------------------------------
+typedef struct {
+  PHILOX Stream;              // Substream positioned at value First
+  long   First;               // Index of the first value of this slice
+  long   Count;               // Number of values in this slice
+  double *Out;                // Output for value First (mapped formats)
+  double *Block;              // Block of generated values (text format)
+  char   *Text;               // Formatted text (text format)
+  size_t Used;                // Bytes in Text
+} WORKER;
+
+//----- Globals -------------------------------------------------------------
+int         Rng = RNG_PHILOX; // Generator
+int         Seed = 1;         // Random number seed
+double      A, K, P;          // Pareto alpha, k and p values
+BPAR_PARAMS Par;              // Inversion constants for -g philox
+int         Threads;          // Number of worker threads
+WORKER      Worker[MAX_THREADS]; // Per-thread state
 
 //----- Function prototypes -------------------------------------------------
 double bpareto(double a, double k, double p); // Returns a bounded Pareto rv
 double rand_val(int seed);                    // Jain's RNG
+void   interactive(void);                     // Prompted (original) mode
+void   usage(void);                           // Print the option summary
+void   set_slice(WORKER *w, long first, long count); // Position a worker
+void   fill_block(WORKER *w, double *x, long n);     // Generate n values
+void   run_workers(void *(*fn)(void *));      // Run fn on every worker
+void   *map_worker(void *arg);                // Generate into Out
+void   *text_worker(void *arg);               // Generate and format
+int    fmt_shortest(double x, char *s);       // Shortest round-trip text
+int    write_text(FILE *fp, long n);
+int    write_mapped(const char *name, TRACE_HEADER *hdr, long n);
 
 //===== Main program ========================================================
-void main(void)
+int main(int argc, char *argv[])
+{
+  char   *out_name = NULL;    // Output file name
+  FILE   *fp;                 // File pointer to output file
+  TRACE_HEADER hdr;           // Trace file header for -f map
+  int    format = FMT_TEXT;   // Output format
+  long   num_values = 0;      // Number of values
+  int    quiet = 0;           // Suppress banner and summary
+  int    status;              // Return status of the writer
+  int    c;                   // Option character
+  struct timespec t0, t1;     // Start and end times
+  double secs;                // Elapsed seconds
+
+  // No arguments runs the original prompted version
+  if (argc == 1)
+  {
+    interactive();
+    return(0);
+  }
+
+  Threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  while ((c = getopt(argc, argv, "o:f:g:s:a:k:p:n:t:q")) != -1)
+  {
+    switch (c)
+    {
+      case 'o': out_name = optarg; break;
+      case 's': Seed = atoi(optarg); break;
+      case 'a': A = atof(optarg); break;
+      case 'k': K = atof(optarg); break;
+      case 'p': P = atof(optarg); break;
+      case 'n': num_values = atol(optarg); break;
+      case 't': Threads = atoi(optarg); break;
+      case 'q': quiet = 1; break;
+      case 'f':
+        if (strcmp(optarg, "text") == 0) format = FMT_TEXT;
+        else if (strcmp(optarg, "raw") == 0) format = FMT_RAW;
+        else if (strcmp(optarg, "map") == 0) format = FMT_MAP;
+        else usage();
+        break;
+      case 'g':
+        if (strcmp(optarg, "philox") == 0) Rng = RNG_PHILOX;
+        else if (strcmp(optarg, "jain") == 0) Rng = RNG_JAIN;
+        else usage();
+        break;
+      default: usage();
+    }
+  }
+  if ((out_name == NULL) || (Seed <= 0) || (A <= 0.0) || (K <= 0.0) ||
+      (P <= K) || (num_values <= 0))
+    usage();
+
+  // Jain's RNG is one sequence, so it cannot be split across threads
+  if ((Threads < 1) || (Rng == RNG_JAIN))
+    Threads = 1;
+  if (Threads > MAX_THREADS)
+    Threads = MAX_THREADS;
+
+  // Seed the selected generator
+  if (Rng == RNG_PHILOX)
+    setup_bpareto(A, K, P, &Par);
+  else
+    rand_val(Seed);
+
+  if (!quiet)
+  {
+    printf("---------------------------------------- genpar2.c ----- \n");
+    printf("-  Generating %ld samples to %s \n", num_values, out_name);
+    printf("-    * alpha   = %f \n", A);
+    printf("-    * k       = %f \n", K);
+    printf("-    * p       = %f \n", P);
+    printf("-    * threads = %d \n", Threads);
+    printf("-------------------------------------------------------- \n");
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  if (format == FMT_MAP)
+  {
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.Seed = (uint64_t) Seed;
+    hdr.Param[0] = A;
+    hdr.Param[1] = K;
+    hdr.Param[2] = P;
+    snprintf(hdr.Desc, sizeof(hdr.Desc), "genpar2 bpareto %s",
+      (Rng == RNG_PHILOX) ? "philox" : "jain");
+    status = write_mapped(out_name, &hdr, num_values);
+  }
+  else if (format == FMT_RAW)
+    status = write_mapped(out_name, NULL, num_values);
+  else
+  {
+    fp = fopen(out_name, "w");
+    if (fp == NULL)
+    {
+      printf("ERROR in creating output file (%s) \n", out_name);
+      exit(1);
+    }
+    status = write_text(fp, num_values);
+    if (fclose(fp) != 0)
+      status = -1;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  if (status != 0)
+  {
+    printf("ERROR in writing output file (%s) \n", out_name);
+    exit(1);
+  }
+
+  if (!quiet)
+  {
+    secs = (t1.tv_sec - t0.tv_sec) + 1.0e-9 * (t1.tv_nsec - t0.tv_nsec);
+    printf("-  Done! %.3f sec (%.1f ns/value) \n", secs,
+      1.0e9 * secs / num_values);
+    printf("-------------------------------------------------------- \n");
+  }
+
+  return(0);
+}
+
+//===========================================================================
+//=  Function for the original prompted mode                                =
+//===========================================================================
+void interactive(void)
 {
   char   in_string[256];      // Input string
   FILE   *fp;                 // File pointer to output file
@@ -91,6 +286,7 @@ void main(void)
     printf("ERROR in creating output file (%s) \n", in_string);
     exit(1);
   }
+  setvbuf(fp, NULL, _IOFBF, TEXT_BUF);
 
   // Prompt for random number seed and then use it
   printf("Random number seed (greater than zero) =========> ");
@@ -137,6 +333,324 @@ void main(void)
   fclose(fp);
 }
 
+//===========================================================================
+//=  Function to print the option summary and exit                          =
+//===========================================================================
+void usage(void)
+{
+  fprintf(stderr, "Usage: genpar2 -o file -a alpha -k k -p p -n num \n");
+  fprintf(stderr, "               [-f text|raw|map] [-g philox|jain] \n");
+  fprintf(stderr, "               [-s seed] [-t threads] [-q] \n");
+  fprintf(stderr, "       genpar2 (no arguments prompts for values) \n");
+  exit(1);
+}
+
+//===========================================================================
+//=  Function to give a worker the values first..first+count-1              =
+//=    - Value i always comes from words 2i and 2i+1 of the Philox          =
+//=      stream, so the output does not depend on the number of threads     =
+//===========================================================================
+void set_slice(WORKER *w, long first, long count)
+{
+  w->First = first;
+  w->Count = count;
+  if (Rng == RNG_PHILOX)
+  {
+    init_pstream(&w->Stream, (uint32_t) Seed, 0, 0);
+    pstream_seek(&w->Stream, 2 * (uint64_t) first);
+  }
+}
+
+//===========================================================================
+//=  Function to fill x[0..n-1] with the worker's next bounded Pareto RVs   =
+//===========================================================================
+void fill_block(WORKER *w, double *x, long n)
+{
+  long i;       // Loop counter
+
+  if (Rng == RNG_PHILOX)
+    pstream_fill_bpareto(&w->Stream, &Par, x, n);
+  else
+    for (i=0; i<n; i++)
+      x[i] = bpareto(A, K, P);
+}
+
+//===========================================================================
+//=  Function to run fn on Worker[0..Threads-1] and wait for all of them    =
+//=    - Worker 0 runs on the calling thread; a worker whose thread         =
+//=      cannot be created also runs there                                  =
+//===========================================================================
+void run_workers(void *(*fn)(void *))
+{
+  pthread_t tid[MAX_THREADS];   // Thread ids
+  int       started[MAX_THREADS]; // Thread was created
+  int       i;                  // Loop counter
+
+  for (i=1; i<Threads; i++)
+    started[i] = (pthread_create(&tid[i], NULL, fn, &Worker[i]) == 0);
+  fn(&Worker[0]);
+  for (i=1; i<Threads; i++)
+  {
+    if (started[i])
+      pthread_join(tid[i], NULL);
+    else
+      fn(&Worker[i]);
+  }
+}
+
+//===========================================================================
+//=  Worker to generate its slice straight into the mapped output           =
+//===========================================================================
+void *map_worker(void *arg)
+{
+  WORKER         *w = (WORKER *) arg;
+  const uint16_t one = 1;     // Endianness probe
+  unsigned char  *b;          // Bytes of one value
+  unsigned char  t;           // Swap temporary
+  long           i;           // Index within the slice
+  long           m;           // Values in this block
+  long           j;           // Loop counter
+  int            l;           // Byte counter
+
+  for (i=0; i<w->Count; i+=m)
+  {
+    m = (w->Count - i < BLOCK) ? w->Count - i : BLOCK;
+    fill_block(w, w->Out + i, m);
+
+    // Byte swap on big-endian hosts
+    if (*(const unsigned char *) &one == 0)
+      for (j=0; j<m; j++)
+      {
+        b = (unsigned char *) &w->Out[i + j];
+        for (l=0; l<4; l++)
+        {
+          t = b[l];  b[l] = b[7 - l];  b[7 - l] = t;
+        }
+      }
+  }
+
+  return(NULL);
+}
+
+//===========================================================================
+//=  Worker to generate and format its slice into its text buffer           =
+//===========================================================================
+void *text_worker(void *arg)
+{
+  WORKER *w = (WORKER *) arg;
+  long   i;           // Loop counter
+
+  fill_block(w, w->Block, w->Count);
+  w->Used = 0;
+  for (i=0; i<w->Count; i++)
+  {
+    w->Used += fmt_shortest(w->Block[i], w->Text + w->Used);
+    w->Text[w->Used++] = '\n';
+  }
+
+  return(NULL);
+}
+
+//===========================================================================
+//=  Function to format x as the shortest decimal that reads back as x      =
+//=    - Starts from the 17 digit form (always exact) and drops digits      =
+//=      while the rounded value still converts back to x                   =
+//=    - Conversion back is exact by Clinger's fast path when the digits    =
+//=      fit in 53 bits and the power of ten is at most 22, else strtod()   =
+//=    - Returns the string length                                          =
+//===========================================================================
+int fmt_shortest(double x, char *s)
+{
+  static const double pow10[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+  char     e17[32];   // x as d.dddddddddddddddde+xx
+  char     dig[18];   // Significant digits of the best form so far
+  char     c[18];     // Candidate digits
+  char     tmp[40];   // Candidate for strtod()
+  int      n = 17;    // Number of digits in dig
+  int      exp10;     // Decimal exponent of dig[0]
+  int      cexp;      // Decimal exponent of c[0]
+  int      m;         // Number of digits in c
+  int      i;         // Loop counter
+  int      len = 0;   // Length of s
+  uint64_t d;         // c as an integer
+  double   y;         // c converted back
+
+  if ((x == 0.0) || !isfinite(x))
+    return(snprintf(s, 32, "%.17g", x));
+  if (x < 0.0)
+  {
+    s[len++] = '-';
+    x = -x;
+  }
+
+  snprintf(e17, sizeof(e17), "%.16e", x);
+  dig[0] = e17[0];
+  memcpy(dig + 1, e17 + 2, 16);
+  exp10 = atoi(e17 + 19);
+  while ((n > 1) && (dig[n - 1] == '0'))
+    n--;
+
+  for (m=n-1; m>=1; m--)
+  {
+    // Round dig to m digits; a tail of exactly 5 may be a 17 digit
+    // rounding of something below half, so let printf round it exactly
+    memcpy(c, dig, m);
+    cexp = exp10;
+    for (i=m+1; (i<n) && (dig[i] == '0'); i++);
+    if ((dig[m] == '5') && (i == n))
+    {
+      snprintf(tmp, sizeof(tmp), "%.*e", m - 1, x);
+      c[0] = tmp[0];
+      memcpy(c + 1, tmp + 2, m - 1);
+      cexp = atoi(tmp + m + 2 - (m == 1));
+    }
+    else if (dig[m] >= '5')
+    {
+      for (i=m-1; (i>=0) && (c[i] == '9'); i--)
+        c[i] = '0';
+      if (i >= 0)
+        c[i]++;
+      else
+      {
+        c[0] = '1';
+        cexp++;
+      }
+    }
+
+    // Convert back and stop at the first length that does not round-trip
+    d = 0;
+    for (i=0; i<m; i++)
+      d = 10 * d + (c[i] - '0');
+    i = cexp - (m - 1);
+    if ((d < ((uint64_t) 1 << 53)) && (i >= -22) && (i <= 22))
+      y = (i >= 0) ? (double) d * pow10[i] : (double) d / pow10[-i];
+    else
+    {
+      snprintf(tmp, sizeof(tmp), "%llue%d", (unsigned long long) d, i);
+      y = strtod(tmp, NULL);
+    }
+    if (y != x)
+      break;
+
+    memcpy(dig, c, m);
+    exp10 = cexp;
+    n = m;
+    while ((n > 1) && (dig[n - 1] == '0'))
+      n--;
+    m = n;
+  }
+
+  // Plain notation for moderate exponents, else d.ddde+xx like %g
+  if ((exp10 < -5) || (exp10 > 16))
+  {
+    s[len++] = dig[0];
+    if (n > 1)
+    {
+      s[len++] = '.';
+      memcpy(s + len, dig + 1, n - 1);
+      len += n - 1;
+    }
+    len += sprintf(s + len, "e%+03d", exp10);
+  }
+  else if (exp10 < 0)
+  {
+    s[len++] = '0';
+    s[len++] = '.';
+    for (i=-1; i>exp10; i--)
+      s[len++] = '0';
+    memcpy(s + len, dig, n);
+    len += n;
+  }
+  else
+  {
+    for (i=0; i<=exp10; i++)
+      s[len++] = (i < n) ? dig[i] : '0';
+    if (n > exp10 + 1)
+    {
+      s[len++] = '.';
+      memcpy(s + len, dig + exp10 + 1, n - exp10 - 1);
+      len += n - exp10 - 1;
+    }
+  }
+  s[len] = '\0';
+
+  return(len);
+}
+
+//===========================================================================
+//=  Function to write n values as text, one per line                       =
+//=    - Each round the workers format one block apiece and the blocks      =
+//=      are written in order, so lines come out in value order             =
+//===========================================================================
+int write_text(FILE *fp, long n)
+{
+  long i;       // Index of the next value
+  long m;       // Values in this round
+  int  j;       // Loop counter
+  int  status = 0;
+
+  for (j=0; j<Threads; j++)
+  {
+    Worker[j].Block = (double *) malloc(BLOCK * sizeof(double));
+    Worker[j].Text = (char *) malloc(BLOCK * LINE_MAX_LEN);
+    if ((Worker[j].Block == NULL) || (Worker[j].Text == NULL))
+    {
+      printf("ERROR in allocating text buffers \n");
+      exit(1);
+    }
+  }
+  setvbuf(fp, NULL, _IOFBF, TEXT_BUF);
+
+  for (i=0; (i<n) && (status == 0); i+=m)
+  {
+    m = 0;
+    for (j=0; j<Threads; j++)
+    {
+      set_slice(&Worker[j], i + m, (n - i - m < BLOCK) ? n - i - m : BLOCK);
+      m += Worker[j].Count;
+    }
+    run_workers(text_worker);
+    for (j=0; j<Threads; j++)
+      if (fwrite(Worker[j].Text, 1, Worker[j].Used, fp) != Worker[j].Used)
+        status = -1;
+  }
+
+  for (j=0; j<Threads; j++)
+  {
+    free(Worker[j].Block);
+    free(Worker[j].Text);
+  }
+
+  return(status);
+}
+
+//===========================================================================
+//=  Function to write n values into a mapped file, one slice per thread    =
+//=    - hdr NULL writes raw doubles, else a trace file (TraceInterface.h)  =
+//===========================================================================
+int write_mapped(const char *name, TRACE_HEADER *hdr, long n)
+{
+  TRACE trace;        // Mapped output file
+  long  first = 0;    // First value of the next slice
+  int   j;            // Loop counter
+
+  if (create_trace(name, (uint64_t) n, hdr, &trace) != 0)
+    return(-1);
+
+  for (j=0; j<Threads; j++)
+  {
+    set_slice(&Worker[j], first, (n - first) / (Threads - j));
+    Worker[j].Out = trace.Data + first;
+    first += Worker[j].Count;
+  }
+  run_workers(map_worker);
+  close_trace(&trace);
+
+  return(0);
+}
+
 //===========================================================================
 //=  Function to generate bounded Pareto distributed RVs using              =
 //=    - Input:  a, k, and p                                                =
@@ -153,7 +667,7 @@ double bpareto(double a, double k, double p)
     z = rand_val(0);
   }
   while ((z == 0) || (z == 1));
-  printf("z: %f", z);
+
   // Generate the bounded Pareto rv using the inversion method
   rv = pow((pow(k, a) / (z*pow((k/p), a) - z + 1)), (1.0/a));
 
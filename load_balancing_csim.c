@@ -5,6 +5,108 @@
 //=   1) offered_load is a command line input, mu is sent in sim(),           =
 //=      lambda is calculated                                                 =
 //=   2) Delay is a command line input if DELAY_ON is defined                 =
+//=   3) If TRACE_ON is defined the last two command line inputs name an      =
+//=      interarrival and a service time trace (genpar2 -f raw or -f map);    =
+//=      either may be - to keep the generated distribution, and the run      =
+//=      ends when a trace runs out                                           =
+//=   4) EMP service times are drawn from the alias table in EMP_FILE (built  =
+//=      from a trace by genalias); mu is then 1 / (trace mean)               =
+//=   5) With VR_ANTI or VR_SOBOL the run is replaced by replications of      =
+//=      REP_TIME sec (after REP_WARM sec of warm-up) until the 95% CI of     =
+//=      the mean response time is within REP_ACC:                            =
+//=        * VR_ANTI: pairs share streams, the second antithetic (u -> 1-u);  =
+//=          each pair average is one observation                             =
+//=        * VR_SOBOL: the first QMC_CUST customers of SOBOL_PTS              =
+//=          replications take Sobol points under one random digital          =
+//=          shift; each shift average is one observation                     =
+//=      Exponentials are drawn by inversion so draws stay monotone in u      =
+//=   6) Arrivals, service times and each policy's random choices have their  =
+//=      own Philox substreams, so customer n has the same interarrival and   =
+//=      service time under every policy.  Build one binary per policy and    =
+//=      run each with the same -s seed (common random numbers); the          =
+//=      per-seed differences give the paired CI for the policy difference    =
+//=   7) With CV_ON the run is also replications (note 5, independent ones    =
+//=      unless VR is on too) and each gives two controls with known means:   =
+//=      its arrival rate (lambda) and the mean service time of its           =
+//=      arrivals.  Response time is adjusted by regression on them, both     =
+//=      CIs are reported and the adjusted one stops the run.  DETER uses     =
+//=      the arrival rate alone                                               =
+//=   8) RUN_REPS runs the replications of note 5 with no VR (independent     =
+//=      ones) in place of the one long run.  In any replication mode -p      =
+//=      procs worker processes (default all cores) run them in parallel      =
+//=      and the parent merges them in replication order, so the stopping     =
+//=      point and results are the same for any -p (ReplicationInterface.h)   =
+//=   9) RUN_FORK is RUN_REPS with one shared warm-up: the model runs         =
+//=      REP_WARM sec once, then every replication is a child forked from     =
+//=      that state (copy-on-write) that reseeds its streams, resets          =
+//=      Resp_table and the facilities and measures REP_TIME sec.  The Util   =
+//=      tables that SERV routes on keep their warm state (as with MSER).     =
+//=      With VR_ANTI each replication of a pair is its own child of the      =
+//=      warm state, so the pair starts from the same point.  The CI is       =
+//=      for the mean given the warm state; not with VR_SOBOL, whose          =
+//=      points drive the first customers                                     =
+//=  10) With MSER_ON the long run watches for the end of its warm-up: each   =
+//=      response time also goes to an MSER-5 detector (StatsInterface.h),    =
+//=      checked each time its batches fill (the run has doubled).  Once      =
+//=      MSER_CHECKS checks in a row find a truncation point in the first     =
+//=      half, Resp_table and the facilities are reset, so the reported       =
+//=      means and the run-length control start from warm state.  CSIM        =
+//=      cannot drop recorded values, so everything up to the detection is    =
+//=      discarded, a little past the truncation point.  The Util tables      =
+//=      feed SERV and are kept.  Replications discard REP_WARM instead       =
+//=  11) -c file checkpoints a replication run: after every group the         =
+//=      merged statistics go to file (CheckpointInterface.h), and a run      =
+//=      started with the same file, build, seed and parameters resumes at    =
+//=      the next group with bit-identical results (any -p); the file is      =
+//=      removed when the run ends.  Groups reseed from (seed, index), so     =
+//=      that is the whole state between them.  CSIM's event list and         =
+//=      processes live inside the library and cannot be saved, so a          =
+//=      single long run (RUN_LENGTH, RUN_REGEN, RUN_SPLIT) cannot be         =
+//=      checkpointed and rejects -c: a long run that may be evicted          =
+//=      (e.g. hours of BPAR) should be built with RUN_REPS and run with      =
+//=      -c, which loses at most the group in progress                        =
+//=  12) RUN_REGEN replaces run-length control with regenerative cycles:      =
+//=      arrivals are Poisson, so an arrival to an empty system (with RR,     =
+//=      one whose turn is queue 1) starts the model afresh.  Each cycle      =
+//=      gives its total response time and customers, and its area under      =
+//=      the number in system and length; ratio estimators give the mean      =
+//=      response time and number in system with CIs (RATIO_STATS), and       =
+//=      the run stops once both are within REGEN_ACC (or at SIM_TIME).  No   =
+//=      warm-up is discarded.  Needs DELAY_OFF and not SERV, whose state     =
+//=      (stale queue lengths, cumulative work) never empties                 =
+//=  13) RUN_SPLIT estimates the probability that a busy cycle (arrival to    =
+//=      an empty system until it is empty again) takes one queue to          =
+//=      OVER_LEVEL customers, by multilevel splitting.  The levels are       =
+//=      every OVER_LEVEL / SPLIT_LEVELS customers; a trajectory entering     =
+//=      level k for the first time is cloned with fork() into R_k copies     =
+//=      that share its weight and go on with fresh substreams, and a copy    =
+//=      ends when its cycle does or it reaches OVER_LEVEL.  Copies run one   =
+//=      at a time (depth first, at most SPLIT_LEVELS processes).  R_k is     =
+//=      1 / (estimated P(level k+1 | level k)), at most SPLIT_RMAX, from     =
+//=      the weighted entrances so far, so each level keeps about one         =
+//=      trajectory going; weights keep the estimate unbiased.  The first     =
+//=      copy is the plain run, so the usual report still holds.  The run     =
+//=      stops once the CI over the busy cycles is within SPLIT_ACC (or at    =
+//=      SIM_TIME); the queue limit check is off                              =
+//=  14) IS_ON adds importance sampling to RUN_REGEN (EXP only) for tail      =
+//=      probabilities of response time: each cycle starts with the           =
+//=      arrival and service rates tilted toward the swap of lambda and       =
+//=      5 mu (IS_TILT of the way, keeping their product), so the servers     =
+//=      are overloaded, until a response time exceeds IS_SLA; then the       =
+//=      rates go back until the cycle ends.  Every draw multiplies the       =
+//=      cycle's likelihood ratio, and each completion is weighted by the     =
+//=      ratio at that moment, so the weighted cycle sums (tail count,        =
+//=      response time, customers, area, length) are unbiased for the         =
+//=      untilted model.  P(response > IS_SLA) gets its CI and relative       =
+//=      error and stops the run at IS_ACC.  CSIM's tables and facilities     =
+//=      cannot take weights, so the rest of the report is for the tilted     =
+//=      model                                                                =
+//=  15) Outside replications every response time also goes to an HDR         =
+//=      log-linear histogram (StatsInterface.h), and p50 to p99.9 are        =
+//=      reported within 0.4% of the recorded values with no range to set,    =
+//=      and to its server's t-digest (a few KB each), which give each        =
+//=      server's p99 and p99.9 and, merged, the whole system's as a check.   =
+//=      Both are reset with Resp_table at the end of the MSER warm-up        =
 //=---------------------------------------------------------------------------=
 //= Example execution:                                                        =
 //=                                                                           =
@@ -70,9 +172,14 @@
 //=                                                                           =
 //=  *** END SIMULATION ***                                                   =
 //=---------------------------------------------------------------------------=
-//=  Build: standard CSIM build                                               =
+//=  Build: standard CSIM build plus DistributionImplementation.c,            =
+//=         StreamImplementation.c, TraceImplementation.c,                    =
+//=         StatsImplementation.c, ReplicationImplementation.c and            =
+//=         CheckpointImplementation.c                                        =
 //=---------------------------------------------------------------------------=
-//=  Execute: project_1                                                       =
+//=  Execute: project_1 [-s seed] [-p procs] [-c file] OfferedLoad [Delay]    =
+//=                    [Traces]                                               =
+//=           -c works only in replication modes (note 11)                    =
 //=---------------------------------------------------------------------------=
 //=  Authors: Emmanuel Rodriguez                                              =
 //=           University of South Florida                                     =
@@ -99,15 +206,148 @@
 //----- Includes --------------------------------------------------------------
 #include <stdio.h>      // Needed for printf()
 #include <stdlib.h>     // Needed for atof()
+#include <string.h>     // Needed for strcmp()
 #include <assert.h>     // Needed for assert()
 #include <math.h>       // Needed for log() and pow()
+#include <time.h>       // Needed for clock_gettime() (before csim.h)
+#include <sys/resource.h> // Needed for getrusage()
+#include <sys/mman.h>   // Needed for mmap()
+#include <sys/wait.h>   // Needed for waitpid()
+#include <unistd.h>     // Needed for fork()
 #include "csim.h"       // Needed for CSIM19 stuff
+#include "DistributionInterface.h" // Needed for dist_sample()
+#include "TraceInterface.h" // Needed for trace_next()
+#include "StatsInterface.h" // Needed for stats_half_width()
+#include "ReplicationInterface.h" // Needed for run_replications()
+#include "CheckpointInterface.h" // Needed for ckpt_save()
 
 //----- Defines ---------------------------------------------------------------
 #define SIM_TIME 2.0e6  // Total simulation time in seconds
-#define EXP             // Define service time distribution (EXP, DETER, BPAR)
+#define EXP             // Define service time distribution (EXP, DETER, BPAR, EMP)
 #define RR            // Define load balancing policy (SHORT, RR, RAND, SERV)
 #define DELAY_OFF       // Define delay on or off (DELAY_ON, DELAY_OFF)
+#define TRACE_OFF       // Define trace input on or off (TRACE_ON, TRACE_OFF)
+#define VR_OFF          // Define variance reduction (VR_OFF, VR_ANTI, VR_SOBOL)
+#define CV_OFF          // Define control variates on or off (CV_ON, CV_OFF)
+#define RUN_LENGTH      // Define run control (RUN_LENGTH, RUN_REPS, RUN_FORK, RUN_REGEN, RUN_SPLIT)
+#define MSER_OFF        // Define warm-up truncation (MSER_ON, MSER_OFF)
+#define IS_OFF          // Define importance sampling (IS_ON, IS_OFF)
+#define SEED 1          // Default seed for the model's random streams (-s)
+#define PROCS 0         // Default replication processes, 0 = all cores (-p)
+#define BPAR_A 1.985    // Bounded pareto alpha value
+#define BPAR_MIN 0.5    // Bounded pareto min value
+#define BPAR_MAX 100.0  // Bounded pareto max value
+#define EMP_FILE "service.emp" // Empirical service time table (genalias -o)
+#define REGEN_MIN 100   // Fewest cycles before stopping (RUN_REGEN)
+#define REGEN_ACC 0.01  // Relative CI half-width at which RUN_REGEN stops
+#define REGEN_EVERY 100 // Cycles between convergence checks (RUN_REGEN)
+#define IS_SLA 100.0    // Response time whose tail IS_ON estimates (sec)
+#define IS_TILT 1.0     // Fraction of the way to swapping the rates (IS_ON)
+#define IS_ACC 0.05     // Relative CI half-width at which IS_ON stops
+#define OVER_LEVEL 100  // Customers in one queue that count as overflow
+#define SPLIT_LEVELS 20 // Splitting levels up to OVER_LEVEL (RUN_SPLIT)
+#define SPLIT_RMAX 20   // Most copies at one level (RUN_SPLIT)
+#define SPLIT_MIN 1000  // Fewest busy cycles before stopping (RUN_SPLIT)
+#define SPLIT_ACC 0.05  // Relative CI half-width at which RUN_SPLIT stops
+#define MSER_CHECKS 2   // Checks in a row that must find the warm-up (MSER_ON)
+#define REP_WARM 1.0e4  // Warm-up discarded from each VR replication (sec)
+#define REP_TIME 1.0e5  // Measured length of each VR replication (sec)
+#define REP_MIN  5      // Fewest VR observations before stopping
+#define REP_MAX  1000   // Most VR observations
+#define REP_ACC  0.01   // Relative CI half-width at which VR stops
+#define SOBOL_PTS 8     // Replications per Sobol shift (VR_SOBOL)
+#define QMC_CUST ((SOBOL_MAXDIM - 1) / 2) // Customers on Sobol points
+#define WARM_REP REP_MAX // Substream of the shared warm-up (RUN_FORK)
+
+//----- Random stream components ----------------------------------------------
+#define SERVICE_COMP 0  // Service times
+#define ARRIVAL_COMP 1  // Interarrival times
+#define SHIFT_COMP   2  // Sobol digital shifts
+#define RR_COMP      3  // Policy choices: RR (none), SHORT and SERV tie-breaks,
+#define SHORT_COMP   4  //   RAND selections; one component per policy so the
+#define RAND_COMP    5  //   other streams line up across policies
+#define SERV_COMP    6
+
+#if defined(SHORT)
+#define POLICY_COMP SHORT_COMP
+#elif defined(RAND)
+#define POLICY_COMP RAND_COMP
+#elif defined(SERV)
+#define POLICY_COMP SERV_COMP
+#else
+#define POLICY_COMP RR_COMP
+#endif
+
+#if defined(VR_ANTI) || defined(VR_SOBOL)
+#define VR_ON
+#endif
+#if defined(VR_ON) || defined(CV_ON) || defined(RUN_REPS) || defined(RUN_FORK)
+#define REP_ON          // Run as replications
+#if defined(TRACE_ON)
+#error "Variance reduction needs generated input (TRACE_OFF)"
+#endif
+#endif
+#if defined(MSER_ON) && (defined(REP_ON) || defined(RUN_REGEN) || \
+    defined(RUN_SPLIT))
+#undef MSER_ON          // Replications discard REP_WARM, cycles need none
+#endif
+#if defined(RUN_SPLIT) && (defined(REP_ON) || defined(TRACE_ON))
+#error "RUN_SPLIT needs no VR/CV or traces"
+#endif
+#if defined(RUN_REGEN) && (defined(REP_ON) || defined(TRACE_ON) || \
+    defined(DELAY_ON) || defined(SERV))
+#error "RUN_REGEN needs no VR/CV or traces, DELAY_OFF and not SERV"
+#endif
+#if defined(IS_ON) && (!defined(RUN_REGEN) || !defined(EXP))
+#error "IS_ON needs RUN_REGEN and EXP"
+#endif
+#if defined(RUN_FORK) && defined(VR_SOBOL)
+#error "Sobol points drive the first customers, which a shared warm-up skips"
+#endif
+#if defined(VR_ANTI)
+#define VR_GROUP 2      // Replications per observation
+#elif defined(VR_SOBOL)
+#define VR_GROUP SOBOL_PTS
+#else
+#define VR_GROUP 1
+#endif
+#if defined(DETER)
+#define CV_Q 1          // Controls: arrival rate (service is constant)
+#else
+#define CV_Q 2          // Controls: arrival rate, mean service time
+#endif
+
+//----- Interarrival time distribution ----------------------------------------
+#ifdef VR_ON
+typedef EXPO_DIST ARRIVAL_DIST;
+#define setup_arrival(d, lambda) setup_expo(1.0 / (lambda), d)
+#else
+typedef ZIG_EXPO_DIST ARRIVAL_DIST;
+#define setup_arrival(d, lambda) setup_zig_expo(1.0 / (lambda), d)
+#endif
+
+//----- Service time distribution ---------------------------------------------
+#if defined(EXP) && defined(VR_ON)
+typedef EXPO_DIST SERVICE_DIST;
+#define setup_service(d, mu) setup_expo(1.0 / (mu), d)
+#define service_mean(d, mu) (1.0 / (mu))
+#elif defined(EXP)
+typedef ZIG_EXPO_DIST SERVICE_DIST;
+#define setup_service(d, mu) setup_zig_expo(1.0 / (mu), d)
+#define service_mean(d, mu) (1.0 / (mu))
+#elif defined(DETER)
+typedef DETER_DIST SERVICE_DIST;
+#define setup_service(d, mu) setup_deter(1.0 / (mu), d)
+#define service_mean(d, mu) (1.0 / (mu))
+#elif defined(EMP)
+typedef EMP_DIST   SERVICE_DIST;
+#define setup_service(d, mu) ((d)->Next = DIST_BUF) // Loaded in sim()
+#define service_mean(d, mu) emp_mean(d)
+#else
+typedef BPAR_DIST  SERVICE_DIST;
+#define setup_service(d, mu) setup_bpar_dist(BPAR_A, BPAR_MIN, BPAR_MAX, d)
+#define service_mean(d, mu) bpareto_mean(&(d)->Par)
+#endif
 
 //----- Globals ---------------------------------------------------------------
 FACILITY Server1;       // Declaration of CSIM Server facility #1
@@ -121,9 +361,90 @@ TABLE    Util3;         // Declaration of CSIM Server table #3
 TABLE    Util4;         // Declaration of CSIM Server table #4
 TABLE    Util5;         // Declaration of CSIM Server table #5
 TABLE    Resp_table;    // Declaration of CSIM Table
+#ifndef REP_ON
+HDR      Resp_hdr;      // Response time percentiles
+TDIGEST  Resp_td[5];    // Response time quantiles of each server
+#endif
 int      Queue_len[5];  // Number of customers in system
 double   Delay;         // Queue state informaion delay
 int      Select_q;      // Queue Chosen
+ARRIVAL_DIST Arrival_dist; // Interarrival time distribution
+SERVICE_DIST Service_dist; // Service time distribution
+PHILOX   Arrival_stream; // Random stream for interarrival times
+PHILOX   Service_stream; // Random stream for service times
+PHILOX   Policy_stream;  // Random stream for the policy's choices
+long     Seed = SEED;    // Seed for all random streams
+int      Procs = PROCS;  // Processes for the replications
+char     *Ckpt_name = NULL; // Checkpoint file (-c)
+#ifdef TRACE_ON
+TRACE    Arrival_trace;  // Interarrival time trace (Map is NULL if unused)
+TRACE    Service_trace;  // Service time trace (Map is NULL if unused)
+#endif
+#ifdef VR_SOBOL
+SOBOL    Qmc;            // Sobol points of the current shift
+double   Qmc_point[SOBOL_MAXDIM]; // Point of the current replication
+#endif
+#ifdef MSER_ON
+MSER     Warm_mser;      // Response times until the warm-up is found
+long     Warm_trunc = -1; // Completions MSER-5 would truncate (-1 = not yet)
+long     Warm_cust;      // Completions discarded at the reset
+int      Warm_checks = 0; // Checks in a row that found a truncation point
+double   Warm_time;      // Time of the reset
+#endif
+#ifdef RUN_REGEN
+RATIO_STATS Regen_resp;  // (response time total, customers) per cycle
+RATIO_STATS Regen_num;   // (area under number in system, length) per cycle
+long     Regen_in = 0;   // Customers in the system
+int      Regen_started = 0; // The first cycle has begun
+double   Regen_start;    // Start of the current cycle
+double   Regen_last;     // Last change in Regen_in
+double   Regen_area;     // Area under Regen_in in the cycle so far
+double   Regen_sum;      // Response times completed in the cycle
+double   Regen_cust;     // Customers completed in the cycle
+#ifdef IS_ON
+RATIO_STATS Is_tail;     // (responses over IS_SLA, customers) per cycle
+ARRIVAL_DIST Arrival_tilt; // Tilted interarrival time distribution
+SERVICE_DIST Service_tilt; // Tilted service time distribution
+double   Is_lambda;      // Tilted arrival rate
+double   Is_mu;          // Tilted service rate
+int      Is_tilted;      // Draws are still tilted in this cycle
+double   Is_lr;          // Likelihood ratio of the cycle's draws so far
+double   Is_over;        // Weighted responses over IS_SLA in the cycle
+double   Regen_len;      // Weighted length of the cycle so far
+#endif
+#endif
+#ifdef RUN_SPLIT
+typedef struct {         // Splitting totals, shared by every copy
+  double   Enter[SPLIT_LEVELS + 1]; // Weight entering each level (0 = cycles)
+  long     Copies;       // Copies forked (their substreams are 1..Copies)
+} SPLIT_SHARED;
+SPLIT_SHARED *Split;     // In shared memory
+long     Split_in = 0;   // Customers in the system
+int      Split_level = 0; // Highest level this cycle has entered
+double   Split_weight = 1.0; // Weight of this copy
+int      Split_child = 0; // This process is a copy
+double   Split_top;      // Enter[SPLIT_LEVELS] at the start of the cycle
+STATS    Split_obs;      // Weighted overflows per busy cycle
+#endif
+#ifdef REP_ON
+STATS    Rep_obs;        // Group averages (independent)
+STATS    Rep_single;     // Every replication, as if independent
+double   Rep_half;       // CI half-width so far
+#ifdef CV_ON
+CV_STATS Rep_cv;         // Group averages with their controls
+#endif
+char     Ckpt_key[256];  // What a checkpoint must match
+typedef struct {         // Replication state saved after each group (-c)
+  long     Next;         // Groups merged
+  int      Stopped;      // The CI target was met
+  STATS    Obs;          // Rep_obs
+  STATS    Single;       // Rep_single
+  double   Half;         // Rep_half
+#ifdef CV_ON
+  CV_STATS Cv;           // Rep_cv
+#endif
+} REP_CKPT;
+#endif
 
 //----- Prototypes ------------------------------------------------------------
 void generate(double lambda, double mu);                  // Customer generator
@@ -134,7 +455,32 @@ void queue4(double service_time, double time_org);        // Single server queue
 void queue5(double service_time, double time_org);        // Single server queue #5
 void load_balancer(double org_time, double service_time); // Load Balancer
 void update_state();                                      // Update system information
-double bounded_pareto();                                  // Generate bounded pareto rv
+void record_resp(int q, double resp);                     // Record a response time
+#ifdef RUN_REGEN
+void regen_arrival();                                     // Close a cycle?
+#endif
+#ifdef RUN_SPLIT
+void split_arrival(double lambda, double mu);             // Split at a level?
+void split_empty();                                       // End of a busy cycle
+#endif
+void setup_csim();                                        // Create CSIM objects
+#ifdef REP_ON
+void replications(double lambda, double mu);              // Run replications
+void run_group(long index, double *out, void *arg);       // One observation
+int  merge_group(long index, const double *out, void *arg); // Add, test CI
+double replicate(double lambda, double mu, long stream_rep, int anti,
+                 double *ctl);                            // One replication
+#endif
+#ifdef RUN_FORK
+void warm_up(double lambda, double mu);                   // Shared warm-up
+#endif
+#if defined(RUN_FORK) && (VR_GROUP > 1)
+double replicate_forked(double lambda, double mu, long stream_rep, int anti,
+                        double *ctl);                     // From warm state
+#endif
+#ifdef TRACE_ON
+int  open_input(char *name, TRACE *t);                    // Open a trace or "-"
+#endif
 
 //=============================================================================
 //==  Main program                                                           ==
@@ -144,11 +490,54 @@ void sim(int argc, char *argv[])
   double   lambda;       // Mean arrival rate (cust/sec)
   double   mu;           // Mean service rate (cust/sec)
   double   offered_load; // Offered load
-  int      i;            // Iteration value
+#ifndef REP_ON
+  int      i;            // Server or level
+#endif
 
   // Create the simulation
   create("sim");
 
+  // Leading -s seed selects the random streams, -p procs the processes
+  while ((argc > 2) && (argv[1][0] == '-'))
+  {
+    if (strcmp(argv[1], "-s") == 0)
+      Seed = atol(argv[2]);
+    else if (strcmp(argv[1], "-p") == 0)
+      Procs = atoi(argv[2]);
+    else if (strcmp(argv[1], "-c") == 0)
+      Ckpt_name = argv[2];
+    else
+    {
+      printf("Usage: ./a.out [-s seed] [-p procs] [-c file] OfferedLoad ...\n");
+      return;
+    }
+    argc -= 2;
+    argv += 2;
+  }
+  if (Procs <= 0)
+    Procs = rep_procs();
+#ifndef REP_ON
+  if (Ckpt_name != NULL)
+  {
+    printf("-c needs a replication mode (RUN_REPS, RUN_FORK, VR_*, CV_ON)\n");
+    printf("A single long run cannot be checkpointed; build with RUN_REPS\n");
+    return;
+  }
+#endif
+
+#ifdef TRACE_ON
+  // The last two arguments name the interarrival and service time traces
+  if (argc < 4)
+  {
+    printf("Usage: ./a.out OfferedLoad [Delay] ArrivalTrace|- ServiceTrace|-\n");
+    return;
+  }
+  if ((open_input(argv[argc - 2], &Arrival_trace) != 0) ||
+      (open_input(argv[argc - 1], &Service_trace) != 0))
+    return;
+  argc -= 2;
+#endif
+
 #ifdef DELAY_ON
   // Output usage
   if (argc != 3)
@@ -168,32 +557,67 @@ void sim(int argc, char *argv[])
   assert((offered_load > 0.0) && (offered_load < 1.0));
 
   // CSIM initializations
-  Server1 = facility("Server1");
-  Server2 = facility("Server2");
-  Server3 = facility("Server3");
-  Server4 = facility("Server4");
-  Server5 = facility("Server5");
-  Resp_table = table("Response time table");
-  Util1 = table("Server1 Util");
-  Util2 = table("Server2 Util");
-  Util3 = table("Server3 Util");
-  Util4 = table("Server4 Util");
-  Util5 = table("Server5 Util");
+  setup_csim();
 
+#if !defined(REP_ON) && !defined(RUN_REGEN) && !defined(RUN_SPLIT)
   // CI run length control
   table_confidence(Resp_table);
   table_run_length(Resp_table, 0.01, 0.95, 120.0);
+#endif
+#ifdef MSER_ON
+  mser_reset(&Warm_mser);
+#endif
+#ifdef RUN_REGEN
+  ratio_reset(&Regen_resp);
+  ratio_reset(&Regen_num);
+#endif
+#ifdef IS_ON
+  ratio_reset(&Is_tail);
+#endif
+#ifndef REP_ON
+  for (i=0; i<5; i++)
+    td_reset(&Resp_td[i]);
+#endif
+#ifdef RUN_SPLIT
+  Split = (SPLIT_SHARED *) mmap(NULL, sizeof(SPLIT_SHARED),
+    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (Split == MAP_FAILED)
+  {
+    printf("ERROR in mapping the splitting totals \n");
+    return;
+  }
+  memset(Split, 0, sizeof(SPLIT_SHARED));
+  stats_reset(&Split_obs);
+#endif
 
   // Initializations
   mu = 1.0;
-  lambda = offered_load * (double)5;
-  Select_q = 1;
-  for(i=0; i<5; i++)
-    Queue_len[i] = 0;
+#ifdef EMP
+  // The measured service times set the service rate
+  if (load_empirical(EMP_FILE, &Service_dist) != 0)
+    return;
+  mu = 1.0 / Service_dist.Mean;
+#endif
+  lambda = offered_load * (double)5 * mu;
+  setup_arrival(&Arrival_dist, lambda);
+  setup_service(&Service_dist, mu);
+  init_pstream(&Arrival_stream, Seed, 0, ARRIVAL_COMP);
+  init_pstream(&Service_stream, Seed, 0, SERVICE_COMP);
+  init_pstream(&Policy_stream, Seed, 0, POLICY_COMP);
+#ifdef IS_ON
+  // Exponential tilt: lambda * mu stays fixed, IS_TILT = 1 swaps them
+  Is_lambda = lambda * pow(5.0 * mu / lambda, IS_TILT);
+  Is_mu = mu * pow(lambda / (5.0 * mu), IS_TILT);
+  setup_arrival(&Arrival_tilt, Is_lambda);
+  setup_service(&Service_tilt, Is_mu);
+#endif
 
   // Output begin-of-simulation banner
   printf("*** BEGIN SIMULATION *** \n");
 
+#ifdef REP_ON
+  replications(lambda, mu);
+#else
   // Initiate generate function and hold for SIM_TIME
   generate(lambda, mu);
 #ifdef DELAY_ON
@@ -208,6 +632,13 @@ void sim(int argc, char *argv[])
   printf("============================================================= \n");
   printf("= Total CPU time     = %6.3f sec      \n", cputime());
   printf("= Total sim time     = %6.3f sec      \n", clock);
+#ifdef MSER_ON
+  if (Warm_trunc >= 0)
+    printf("= MSER-5 warm-up     = %ld cust, reset at %ld cust (%.3f sec) \n",
+      Warm_trunc, Warm_cust, Warm_time);
+  else
+    printf("= MSER-5 warm-up     = not found, nothing discarded \n");
+#endif
   printf("= Total completions  = %ld cust       \n",
     (completions(Server1) + completions(Server2) + completions(Server3) + completions(Server4) + completions(Server5)));
   printf("=------------------------------------------------------------ \n");
@@ -245,9 +676,67 @@ void sim(int argc, char *argv[])
   printf("=------------------------------------------------------------ \n");
   printf("& Table mean for response time = %6.3f sec   \n",
     table_mean(Resp_table));
+#ifndef REP_ON
+  printf("& Response time p50    = %6.3f sec \n",
+    hdr_percentile(&Resp_hdr, 0.5));
+  printf("& Response time p90    = %6.3f sec \n",
+    hdr_percentile(&Resp_hdr, 0.9));
+  printf("& Response time p99    = %6.3f sec \n",
+    hdr_percentile(&Resp_hdr, 0.99));
+  printf("& Response time p99.9  = %6.3f sec \n",
+    hdr_percentile(&Resp_hdr, 0.999));
+  for (i=0; i<5; i++)
+    printf("& Server %d p99, p99.9  = %6.3f sec, %6.3f sec (t-digest) \n",
+      i + 1, td_quantile(&Resp_td[i], 0.99), td_quantile(&Resp_td[i], 0.999));
+  for (i=1; i<5; i++)
+    td_merge(&Resp_td[0], &Resp_td[i]);
+  printf("& All p99, p99.9       = %6.3f sec, %6.3f sec (t-digest) \n",
+    td_quantile(&Resp_td[0], 0.99), td_quantile(&Resp_td[0], 0.999));
+#endif
+#ifdef RUN_REGEN
+  printf("=------------------------------------------------------------ \n");
+  printf("& Regeneration cycles  = %ld \n", Regen_resp.N);
+  printf("& Mean num in system   = %6.3f cust (regenerative) \n",
+    ratio_mean(&Regen_num));
+  printf("& 95%% CI half-width    = %6.3f cust (%.4f relative) \n",
+    ratio_half_width(&Regen_num, 0.95),
+    ratio_half_width(&Regen_num, 0.95) / ratio_mean(&Regen_num));
+  printf("& Mean response time   = %6.3f sec (regenerative) \n",
+    ratio_mean(&Regen_resp));
+  printf("& 95%% CI half-width    = %6.3f sec (%.4f relative) \n",
+    ratio_half_width(&Regen_resp, 0.95),
+    ratio_half_width(&Regen_resp, 0.95) / ratio_mean(&Regen_resp));
+#endif
+#ifdef IS_ON
+  printf("& Tilted rates         = %6.3f cust/sec, %6.3f cust/sec \n",
+    Is_lambda, Is_mu);
+  printf("& P(resp > %6.1f sec) = %e (importance sampling) \n", IS_SLA,
+    ratio_mean(&Is_tail));
+  printf("& Tail 95%% CI half-width = %e (%.4f relative) \n",
+    ratio_half_width(&Is_tail, 0.95),
+    ratio_half_width(&Is_tail, 0.95) / ratio_mean(&Is_tail));
+  printf("& Relative error       = %.4f \n",
+    ratio_half_width(&Is_tail, 0.95) / t_quantile(0.975, Is_tail.N - 1) /
+    ratio_mean(&Is_tail));
+#endif
+#ifdef RUN_SPLIT
+  printf("=------------------------------------------------------------ \n");
+  printf("& Overflow level       = %d cust in one queue \n", OVER_LEVEL);
+  printf("& Busy cycles          = %ld \n", Split_obs.N);
+  printf("& Copies forked        = %ld \n", Split->Copies);
+  for (i=0; i<SPLIT_LEVELS; i++)
+    printf("& P(%3d | %3d cust)    = %.4f \n",
+      (i + 1) * OVER_LEVEL / SPLIT_LEVELS, i * OVER_LEVEL / SPLIT_LEVELS,
+      (Split->Enter[i] > 0.0) ? Split->Enter[i + 1] / Split->Enter[i] : 0.0);
+  printf("& P(overflow in cycle) = %e +/- %e (95%% CI) \n",
+    stats_mean(&Split_obs), stats_half_width(&Split_obs, 0.95));
+  printf("& Overflows per sec    = %e \n",
+    stats_mean(&Split_obs) * Split_obs.N / clock);
+#endif
   printf("============================================================= \n");
 
   report_table(Resp_table);
+#endif
 
   // Output end-of-simulation banner
   printf("*** END SIMULATION *** \n");
@@ -261,13 +750,22 @@ void generate(double lambda, double mu)
 {
   double   interarrival_time;    // Interarrival time to next send
   double   service_time;         // Service time for this customer
+#ifdef VR_SOBOL
+  int      num_cust = 0;         // Customers generated so far
+#endif
 //  int      i;                    // Iteration value
 
+#if !defined(IS_ON) && !defined(RUN_SPLIT)
+  (void)lambda;                  // Only tilting and splitting use them
+  (void)mu;
+#endif
+
   create("generate");
 
   // Loop forever to create customers
   while(1)
   {
+#ifndef RUN_SPLIT
 	  // Check for unstable system
 	  if (qlength(Server1) > 100 || qlength(Server2) > 100 || qlength(Server3) > 100 || qlength(Server4) > 100 || qlength(Server5) > 100)
     {
@@ -275,24 +773,77 @@ void generate(double lambda, double mu)
       getchar();
       exit(1);
     }
+#endif
 
 
     // Pull an interarrival time and hold for it
-    interarrival_time = exponential(1.0 / lambda);
+#ifdef TRACE_ON
+    if (Arrival_trace.Map != NULL)
+    {
+      if (!trace_next(&Arrival_trace, &interarrival_time))
+        break;
+    }
+    else
+#endif
+#ifdef VR_SOBOL
+    if (num_cust < QMC_CUST)
+      interarrival_time = dist_value(&Arrival_dist, Qmc_point[2 * num_cust]);
+    else
+#endif
+#ifdef IS_ON
+    if (Is_tilted)
+    {
+      interarrival_time = dist_sample(&Arrival_tilt, &Arrival_stream);
+      Is_lr *= (lambda / Is_lambda) *
+        exp(-(lambda - Is_lambda) * interarrival_time);
+    }
+    else
+#endif
+    interarrival_time = dist_sample(&Arrival_dist, &Arrival_stream);
     hold(interarrival_time);
+#ifdef RUN_REGEN
+    regen_arrival();
+#endif
 
     // Pull a service time
-#if defined(EXP)
-    service_time = exponential(1.0 / mu);
-#elif defined(DETER)
-    service_time = mu;
-#else
-    service_time = bounded_pareto();
+#ifdef TRACE_ON
+    if (Service_trace.Map != NULL)
+    {
+      if (!trace_next(&Service_trace, &service_time))
+        break;
+    }
+    else
+#endif
+#ifdef VR_SOBOL
+    if (num_cust < QMC_CUST)
+      service_time = dist_value(&Service_dist, Qmc_point[2 * num_cust + 1]);
+    else
+#endif
+#ifdef IS_ON
+    if (Is_tilted)
+    {
+      service_time = dist_sample(&Service_tilt, &Service_stream);
+      Is_lr *= (mu / Is_mu) * exp(-(mu - Is_mu) * service_time);
+    }
+    else
+#endif
+    service_time = dist_sample(&Service_dist, &Service_stream);
+#ifdef VR_SOBOL
+    num_cust++;
 #endif
 
     // Load balance jobs among servers
     load_balancer(clock, service_time);
+#ifdef RUN_SPLIT
+    split_arrival(lambda, mu);
+#endif
   }
+
+#ifdef TRACE_ON
+  // A trace ran out, so end the run with the statistics so far
+  fprintf(stderr, "\nTrace exhausted at %f sec\n", clock);
+  set(converged);
+#endif
 }
 
 //=============================================================================
@@ -351,7 +902,7 @@ void load_balancer (double org_time, double service_time)
   // Randomly select queue if tie occurs
   if(num_ties > 1)
   {
-    rv = uniform(0.0,(double)num_ties);
+    rv = pstream_uniform(&Policy_stream, 0.0, (double)num_ties);
 
     for(i=1; i<=num_ties; i++)
     {
@@ -407,7 +958,7 @@ void load_balancer (double org_time, double service_time)
     }
     else
     {
-      rv = uniform(0.0,(double)serv_ties);
+      rv = pstream_uniform(&Policy_stream, 0.0, (double)serv_ties);
 
       for(i=1; i<=serv_ties; i++)
       {
@@ -462,6 +1013,402 @@ void load_balancer (double org_time, double service_time)
 #endif
 }
 
+//=============================================================================
+//==  Function to create the CSIM objects and reset the model state          ==
+//=============================================================================
+void setup_csim()
+{
+  int      i;            // Iteration value
+
+  Server1 = facility("Server1");
+  Server2 = facility("Server2");
+  Server3 = facility("Server3");
+  Server4 = facility("Server4");
+  Server5 = facility("Server5");
+  Resp_table = table("Response time table");
+  Util1 = table("Server1 Util");
+  Util2 = table("Server2 Util");
+  Util3 = table("Server3 Util");
+  Util4 = table("Server4 Util");
+  Util5 = table("Server5 Util");
+
+  Select_q = 1;
+  for(i=0; i<5; i++)
+    Queue_len[i] = 0;
+}
+
+#ifdef REP_ON
+//=============================================================================
+//==  Function to run replications until the CI reaches REP_ACC              ==
+//==    - Replications within a group (antithetic pair or Sobol shift) are   ==
+//==      dependent by design; group averages are independent and give the   ==
+//==      CI                                                                 ==
+//==    - With CV_ON the group averages of the controls go with each one     ==
+//==    - Groups run on Procs processes and are merged in order              ==
+//=============================================================================
+void replications(double lambda, double mu)
+{
+  double   rate[2];      // lambda and mu for run_group()
+  double   mean;         // Estimate of the mean response time
+  double   wall;         // Wall-clock time (sec)
+  double   cpu;          // CPU time of this and the worker processes
+  long     groups;       // Groups merged
+  long     first = 0;    // Groups restored from the checkpoint
+  int      stopped = 0;  // The checkpoint had met the CI target
+  REP_CKPT ck;           // Checkpoint
+  struct timespec t0, t1; // Start and end times
+  struct rusage ru;      // Resource use of the workers
+#ifdef CV_ON
+  double   ctl_mean[2];  // Known means of the controls
+  double   beta[CV_MAX]; // Control coefficients
+  double   raw_half;     // Unadjusted CI half-width
+
+  ctl_mean[0] = lambda;
+  ctl_mean[1] = service_mean(&Service_dist, mu);
+  cv_reset(&Rep_cv, CV_Q, ctl_mean);
+#endif
+
+  stats_reset(&Rep_obs);
+  stats_reset(&Rep_single);
+  Rep_half = HUGE_VAL;
+  rate[0] = lambda;
+  rate[1] = mu;
+
+  // Pick up where a checkpoint of this very run left off
+  if (Ckpt_name != NULL)
+  {
+    snprintf(Ckpt_key, sizeof(Ckpt_key), "%s %s %ld %.17g %.17g %.17g",
+      __DATE__, __TIME__, Seed, lambda, mu, Delay);
+    switch (ckpt_load(Ckpt_name, Ckpt_key, &ck, sizeof(ck)))
+    {
+      case 1:
+        first = ck.Next;
+        stopped = ck.Stopped;
+        Rep_obs = ck.Obs;
+        Rep_single = ck.Single;
+        Rep_half = ck.Half;
+#ifdef CV_ON
+        Rep_cv = ck.Cv;
+#endif
+        break;
+      case -1:
+        exit(1);
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  groups = first;
+  if (!stopped)
+  {
+#ifdef RUN_FORK
+    warm_up(lambda, mu);
+    groups = run_replications_forked(Procs, first, REP_MAX, VR_GROUP + 2,
+                                     run_group, merge_group, rate);
+#else
+    groups = run_replications(Procs, first, REP_MAX, VR_GROUP + 2,
+                              run_group, merge_group, rate);
+#endif
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  wall = (t1.tv_sec - t0.tv_sec) + 1.0e-9 * (t1.tv_nsec - t0.tv_nsec);
+  if (groups < 0)
+    exit(1);
+  if (Ckpt_name != NULL)
+    ckpt_remove(Ckpt_name);
+  getrusage(RUSAGE_CHILDREN, &ru);
+  cpu = cputime() + ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+        1.0e-6 * (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
+#ifdef CV_ON
+  mean = cv_mean(&Rep_cv);
+#else
+  mean = stats_mean(&Rep_obs);
+#endif
+
+  // Output results
+  printf("============================================================= \n");
+  printf("= Lambda               = %6.3f cust/sec   \n", lambda);
+  printf("= Mu (for each server) = %6.3f cust/sec   \n", mu);
+  printf("============================================================= \n");
+#if defined(VR_ANTI)
+  printf("= Variance reduction   = antithetic pairs \n");
+#elif defined(VR_SOBOL)
+  printf("= Variance reduction   = Sobol, %d points per shift \n", SOBOL_PTS);
+#endif
+#ifdef CV_ON
+  printf("= Control variates     = %s \n",
+    (CV_Q == 1) ? "arrival rate" : "arrival rate, mean service time");
+#endif
+#ifdef RUN_FORK
+  printf("= Replications         = %ld x %.0f sec (one shared %.0f sec warm-up) \n",
+    groups * VR_GROUP, REP_TIME, REP_WARM);
+#else
+  printf("= Replications         = %ld x %.0f sec (+ %.0f sec warm-up) \n",
+    groups * VR_GROUP, REP_TIME, REP_WARM);
+#endif
+  printf("= Processes            = %d \n", Procs);
+  if (first > 0)
+    printf("= Resumed at group     = %ld (%s) \n", first, Ckpt_name);
+  printf("= Total CPU time       = %6.3f sec      \n", cpu);
+  printf("= Wall-clock time      = %6.3f sec      \n", wall);
+  printf("=------------------------------------------------------------ \n");
+#ifdef CV_ON
+  raw_half = stats_half_width(&Rep_obs, 0.95);
+  printf("& Mean response time   = %6.3f sec (raw) \n", stats_mean(&Rep_obs));
+  printf("& 95%% CI half-width    = %6.3f sec (%.4f relative) \n",
+    raw_half, raw_half / stats_mean(&Rep_obs));
+  printf("& Mean response time   = %6.3f sec (control variates) \n", mean);
+  printf("& 95%% CI half-width    = %6.3f sec (%.4f relative) \n",
+    Rep_half, Rep_half / mean);
+  if (cv_beta(&Rep_cv, beta) == 0)
+  {
+    printf("& Control coefficients = %.4f", beta[0]);
+    if (CV_Q == 2)
+      printf(", %.4f", beta[1]);
+    printf(" \n");
+  }
+  printf("& CI width ratio       = %6.2f (raw / control variates) \n",
+    raw_half / Rep_half);
+#else
+  printf("& Mean response time   = %6.3f sec      \n", mean);
+  printf("& 95%% CI half-width    = %6.3f sec (%.4f relative) \n",
+    Rep_half, Rep_half / mean);
+#endif
+#ifdef VR_ON
+  printf("& Variance ratio       = %6.2f (independent / this method) \n",
+    stats_var(&Rep_single) / (VR_GROUP * stats_var(&Rep_obs)));
+#endif
+  printf("============================================================= \n");
+}
+
+//=============================================================================
+//==  Function for observation index: its VR_GROUP replications, then the    ==
+//==  control sums (runs in a worker process)                                ==
+//=============================================================================
+void run_group(long index, double *out, void *arg)
+{
+  double   *rate = (double *) arg; // lambda and mu
+  double   ctl[2];       // Controls of one replication
+  int      k;            // Replication within the group
+#ifdef VR_SOBOL
+  PHILOX   shift_stream; // Stream for the Sobol shift
+
+  init_pstream(&shift_stream, Seed, index, SHIFT_COMP);
+  init_sobol(&Qmc, 2 * QMC_CUST, &shift_stream);
+#endif
+
+  out[VR_GROUP] = out[VR_GROUP + 1] = 0.0;
+  for (k=0; k<VR_GROUP; k++)
+  {
+#ifdef VR_SOBOL
+    sobol_next(&Qmc, Qmc_point);
+    out[k] = replicate(rate[0], rate[1], index * VR_GROUP + k, 0, ctl);
+#elif defined(RUN_FORK) && (VR_GROUP > 1)
+    out[k] = replicate_forked(rate[0], rate[1], index, k, ctl);
+#else
+    out[k] = replicate(rate[0], rate[1], index, k, ctl);
+#endif
+    out[VR_GROUP] += ctl[0];
+    out[VR_GROUP + 1] += ctl[1];
+  }
+}
+
+//=============================================================================
+//==  Function to merge observation index; returns 1 when the CI is met      ==
+//=============================================================================
+int merge_group(long index, const double *out, void *arg)
+{
+  double   sum = 0.0;    // Sum over the group
+  double   mean;         // Estimate so far
+  int      stop;         // The CI target is met
+  REP_CKPT ck;           // Checkpoint
+  int      k;            // Replication within the group
+#ifdef CV_ON
+  double   ctl[2];       // Group averages of the controls
+#endif
+
+  (void) arg;
+  for (k=0; k<VR_GROUP; k++)
+  {
+    stats_add(&Rep_single, out[k]);
+    sum += out[k];
+  }
+  stats_add(&Rep_obs, sum / VR_GROUP);
+#ifdef CV_ON
+  ctl[0] = out[VR_GROUP] / VR_GROUP;
+  ctl[1] = out[VR_GROUP + 1] / VR_GROUP;
+  cv_add(&Rep_cv, sum / VR_GROUP, ctl);
+  Rep_half = cv_half_width(&Rep_cv, 0.95);
+  mean = cv_mean(&Rep_cv);
+#else
+  Rep_half = stats_half_width(&Rep_obs, 0.95);
+  mean = stats_mean(&Rep_obs);
+#endif
+  stop = (Rep_obs.N >= REP_MIN) && (Rep_half <= REP_ACC * mean);
+
+  // Everything the next group needs, so a killed run can resume here
+  if (Ckpt_name != NULL)
+  {
+    memset(&ck, 0, sizeof(ck));
+    ck.Next = index + 1;
+    ck.Stopped = stop;
+    ck.Obs = Rep_obs;
+    ck.Single = Rep_single;
+    ck.Half = Rep_half;
+#ifdef CV_ON
+    ck.Cv = Rep_cv;
+#endif
+    ckpt_save(Ckpt_name, Ckpt_key, &ck, sizeof(ck));
+  }
+
+  return stop;
+}
+
+//=============================================================================
+//==  Function for one replication: returns its mean response time           ==
+//==    - stream_rep selects the substreams; anti makes them antithetic      ==
+//==    - ctl gets the arrival rate and mean service time of the arrivals    ==
+//==      after warm-up (CV_ON)                                              ==
+//==    - With RUN_FORK it runs in a child of the warm model: new streams    ==
+//==      (and empty variate buffers) continue from the shared state         ==
+//=============================================================================
+double replicate(double lambda, double mu, long stream_rep, int anti,
+                 double *ctl)
+{
+  double   y;            // Mean response time
+  double   cust;         // Arrivals after warm-up
+  double   cust0;        // Arrivals and their service time before it
+  double   serv0;
+
+#ifndef RUN_FORK
+  setup_csim();
+#endif
+  setup_arrival(&Arrival_dist, lambda);
+  setup_service(&Service_dist, mu);
+  init_pstream(&Arrival_stream, Seed, stream_rep, ARRIVAL_COMP);
+  init_pstream(&Service_stream, Seed, stream_rep, SERVICE_COMP);
+  init_pstream(&Policy_stream, Seed, stream_rep, POLICY_COMP);
+  pstream_antithetic(&Arrival_stream, anti);
+  pstream_antithetic(&Service_stream, anti);
+  pstream_antithetic(&Policy_stream, anti);
+
+#ifndef RUN_FORK
+  generate(lambda, mu);
+#ifdef DELAY_ON
+  update_state();
+#endif
+
+  // Discard the warm-up
+  hold(REP_WARM);
+#endif
+
+  // Measure for REP_TIME; the Util tables feed SERV and are kept
+  reset_table(Resp_table);
+  reset_facilities();
+  cust0 = (double)(table_cnt(Util1) + table_cnt(Util2) + table_cnt(Util3) +
+                   table_cnt(Util4) + table_cnt(Util5));
+  serv0 = table_sum(Util1) + table_sum(Util2) + table_sum(Util3) +
+          table_sum(Util4) + table_sum(Util5);
+  hold(REP_TIME);
+  y = table_mean(Resp_table);
+
+  // The Util tables hold the service time of every arrival
+  cust = (double)(table_cnt(Util1) + table_cnt(Util2) + table_cnt(Util3) +
+                  table_cnt(Util4) + table_cnt(Util5)) - cust0;
+  ctl[0] = cust / REP_TIME;
+  ctl[1] = (table_sum(Util1) + table_sum(Util2) + table_sum(Util3) +
+            table_sum(Util4) + table_sum(Util5) - serv0) / cust;
+
+#ifndef RUN_FORK
+  // Delete the processes and CSIM objects for the next replication
+  rerun();
+#endif
+
+  return y;
+}
+#endif
+
+#ifdef RUN_FORK
+//=============================================================================
+//==  Function to run the warm-up that every replication is forked from      ==
+//=============================================================================
+void warm_up(double lambda, double mu)
+{
+  setup_arrival(&Arrival_dist, lambda);
+  setup_service(&Service_dist, mu);
+  init_pstream(&Arrival_stream, Seed, WARM_REP, ARRIVAL_COMP);
+  init_pstream(&Service_stream, Seed, WARM_REP, SERVICE_COMP);
+  init_pstream(&Policy_stream, Seed, WARM_REP, POLICY_COMP);
+
+  generate(lambda, mu);
+#ifdef DELAY_ON
+  update_state();
+#endif
+  hold(REP_WARM);
+}
+#endif
+
+#if defined(RUN_FORK) && (VR_GROUP > 1)
+//=============================================================================
+//==  Function to run one replication of a group in its own child, so every  ==
+//==  one starts from the warm state this process was forked with            ==
+//=============================================================================
+double replicate_forked(double lambda, double mu, long stream_rep, int anti,
+                        double *ctl)
+{
+  double   *res;         // y and the two controls (shared)
+  double   y;            // Mean response time
+  pid_t    pid;          // The child
+  int      status;       // Its exit status
+
+  res = (double *) mmap(NULL, 3 * sizeof(double), PROT_READ | PROT_WRITE,
+    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (res == MAP_FAILED)
+  {
+    fprintf(stderr, "ERROR in mapping a replication result \n");
+    exit(1);
+  }
+
+  fflush(NULL);
+  pid = fork();
+  if (pid < 0)
+  {
+    fprintf(stderr, "ERROR in forking replication %ld \n", stream_rep);
+    exit(1);
+  }
+  if (pid == 0)
+  {
+    res[0] = replicate(lambda, mu, stream_rep, anti, res + 1);
+    _exit(0);
+  }
+  if ((waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) ||
+      (WEXITSTATUS(status) != 0))
+  {
+    fprintf(stderr, "ERROR replication %ld did not finish \n", stream_rep);
+    exit(1);
+  }
+
+  y = res[0];
+  ctl[0] = res[1];
+  ctl[1] = res[2];
+  munmap(res, 3 * sizeof(double));
+  return y;
+}
+#endif
+
+#ifdef TRACE_ON
+//=============================================================================
+//==  Function to open an input trace ("-" leaves it unused)                 ==
+//=============================================================================
+int open_input(char *name, TRACE *t)
+{
+  t->Map = NULL;
+  if (strcmp(name, "-") == 0)
+    return 0;
+
+  return open_trace(name, t);
+}
+#endif
+
 //=============================================================================
 //==  Function for state update                                              ==
 //=============================================================================
@@ -499,7 +1446,7 @@ void queue1(double service_time, double time_org)
   release(Server1);
 
   // Record the response time
-  record((clock - time_org), Resp_table);
+  record_resp(0, clock - time_org);
 }
 
 //=============================================================================
@@ -517,7 +1464,7 @@ void queue2(double service_time, double time_org)
   release(Server2);
 
   // Record the response time
-  record((clock - time_org), Resp_table);
+  record_resp(1, clock - time_org);
 }
 
 //=============================================================================
@@ -535,7 +1482,7 @@ void queue3(double service_time, double time_org)
   release(Server3);
 
   // Record the response time
-  record((clock - time_org), Resp_table);
+  record_resp(2, clock - time_org);
 }
 
 //=============================================================================
@@ -553,7 +1500,7 @@ void queue4(double service_time, double time_org)
   release(Server4);
 
   // Record the response time
-  record((clock - time_org), Resp_table);
+  record_resp(3, clock - time_org);
 }
 
 //=============================================================================
@@ -571,36 +1518,252 @@ void queue5(double service_time, double time_org)
   release(Server5);
 
   // Record the response time
-  record((clock - time_org), Resp_table);
+  record_resp(4, clock - time_org);
 }
 
 //=============================================================================
-//==  Function for bounded pareto distribution                               ==
-//==    - Inversion expression from genpar2.c                                ==
+//==  Function to record a response time (and look for the end of warm-up)   ==
 //=============================================================================
-double bounded_pareto()
+void record_resp(int q, double resp)
 {
-  double a;     // Alpha value
-  double min;   // Min value
-  double max;   // Max value
-  double z;     // Uniform random number from 0 to 1
-  double rv;    // RV to be returned
+#ifdef MSER_ON
+  long     d;            // Truncation point found by this check
+  int      i;            // Server
+#endif
 
+  record(resp, Resp_table);
+#ifndef REP_ON
+  hdr_record(&Resp_hdr, resp);
+  td_add(&Resp_td[q], resp);
+#else
+  (void)q;
+#endif
 
-  // Initialize parameters
-  a = 1.985;
-  min = 0.5;
-  max = 100.0;
+#if defined(RUN_REGEN) && defined(IS_ON)
+  // Weighted by the ratio so far: it covers every draw this depends on
+  Regen_area += Is_lr * Regen_in * (clock - Regen_last);
+  Regen_len += Is_lr * (clock - Regen_last);
+  Regen_last = clock;
+  Regen_in--;
+  Regen_sum += Is_lr * resp;
+  Regen_cust += Is_lr;
+  if (resp > IS_SLA)
+  {
+    Is_over += Is_lr;
+    Is_tilted = 0;
+  }
+#elif defined(RUN_REGEN)
+  Regen_area += Regen_in * (clock - Regen_last);
+  Regen_last = clock;
+  Regen_in--;
+  Regen_sum += resp;
+  Regen_cust++;
+#endif
+#ifdef RUN_SPLIT
+  if (--Split_in == 0)
+    split_empty();
+#endif
 
-  // Pull a uniform RV
-  do
+#ifdef MSER_ON
+  // Check when the batches fill; reset once, when the warm-up has been found
+  if ((Warm_trunc < 0) && mser_add(&Warm_mser, resp) &&
+      (Warm_mser.Count == MSER_MAX))
   {
-    z = uniform(0.0,1.0);
+    d = mser_truncation(&Warm_mser);
+    Warm_checks = (d >= 0) ? Warm_checks + 1 : 0;
+    if (Warm_checks == MSER_CHECKS)
+    {
+      Warm_trunc = d;
+      Warm_cust = Warm_mser.N;
+      Warm_time = clock;
+      reset_table(Resp_table);
+      hdr_reset(&Resp_hdr);
+      for (i=0; i<5; i++)
+        td_reset(&Resp_td[i]);
+      reset_facilities();
+    }
   }
-  while ((z == 0) || (z == 1));
+#endif
+}
 
-  // Generate the bounded Pareto rv using the inversion method
-  rv = pow((pow(min, a) / (z*pow((min/max), a) - z + 1)), (1.0/a));
+#ifdef RUN_REGEN
+//=============================================================================
+//==  Function to count an arrival, closing the cycle if it finds the        ==
+//==  system empty (and, for RR, queue 1 next), and to stop the run when     ==
+//==  the regenerative CIs are within REGEN_ACC                              ==
+//=============================================================================
+void regen_arrival()
+{
+#ifdef RR
+  if ((Regen_in == 0) && (Select_q == 1))
+#else
+  if (Regen_in == 0)
+#endif
+  {
+    if (Regen_started)
+    {
+#ifdef IS_ON
+      Regen_len += Is_lr * (clock - Regen_last);
+      ratio_add(&Regen_resp, Regen_sum, Regen_cust);
+      ratio_add(&Regen_num, Regen_area, Regen_len);
+      ratio_add(&Is_tail, Is_over, Regen_cust);
+      if ((Is_tail.N >= REGEN_MIN) && (Is_tail.N % REGEN_EVERY == 0) &&
+          (ratio_mean(&Is_tail) > 0.0) &&
+          (ratio_half_width(&Is_tail, 0.95) <=
+             IS_ACC * ratio_mean(&Is_tail)))
+        set(converged);
+#else
+      ratio_add(&Regen_resp, Regen_sum, Regen_cust);
+      ratio_add(&Regen_num, Regen_area, clock - Regen_start);
+      if ((Regen_resp.N >= REGEN_MIN) && (Regen_resp.N % REGEN_EVERY == 0) &&
+          (ratio_half_width(&Regen_resp, 0.95) <=
+             REGEN_ACC * ratio_mean(&Regen_resp)) &&
+          (ratio_half_width(&Regen_num, 0.95) <=
+             REGEN_ACC * ratio_mean(&Regen_num)))
+        set(converged);
+#endif
+    }
+    Regen_started = 1;
+    Regen_start = clock;
+    Regen_area = 0.0;
+    Regen_sum = 0.0;
+    Regen_cust = 0.0;
+#ifdef IS_ON
+    // The new cycle starts tilted, with nothing drawn yet
+    Regen_len = 0.0;
+    Is_over = 0.0;
+    Is_lr = 1.0;
+    Is_tilted = 1;
+#endif
+  }
+#ifdef IS_ON
+  else
+  {
+    Regen_area += Is_lr * Regen_in * (clock - Regen_last);
+    Regen_len += Is_lr * (clock - Regen_last);
+  }
+#else
+  else
+    Regen_area += Regen_in * (clock - Regen_last);
+#endif
+  Regen_last = clock;
+  Regen_in++;
+
+  if (clock >= SIM_TIME)
+    set(converged);
+}
+#endif
+
+#ifdef RUN_SPLIT
+//=============================================================================
+//==  Function to count an arrival and split the trajectory if its queue     ==
+//==  has entered a new level                                                ==
+//==    - Called after load_balancer(), before the new customer's process    ==
+//==      has run, so its queue is one longer than CSIM shows                ==
+//=============================================================================
+void split_arrival(double lambda, double mu)
+{
+  FACILITY server[5];    // The servers by index
+  double   r;            // Copies at this level
+  long     len;          // Customers in the chosen queue
+  pid_t    pid;          // A copy
+  int      status;       // Its exit status
+  int      q;            // Chosen queue
+  int      j;            // Copy
+
+#if !defined(EXP) && !defined(DETER)
+  (void)mu;              // EMP and BPAR service ignore it
+#endif
+  server[0] = Server1;  server[1] = Server2;  server[2] = Server3;
+  server[3] = Server4;  server[4] = Server5;
+
+  // A customer finding the system empty starts a busy cycle (level 0); only
+  // the plain run gets here, so its weight goes back to 1
+  if (Split_in++ == 0)
+  {
+    Split_level = 0;
+    Split_weight = 1.0;
+    Split_top = Split->Enter[SPLIT_LEVELS];
+    Split->Enter[0] += 1.0;
+  }
+
+#if (defined(RAND) || defined(SHORT) || defined(SERV))
+  q = Select_q;
+#else
+  q = (Select_q == 1) ? 4 : Select_q - 2; // RR has moved on to the next
+#endif
+  len = qlength(server[q]) + num_busy(server[q]) + 1;
+  if ((Split_level == SPLIT_LEVELS) ||
+      (len < (Split_level + 1) * OVER_LEVEL / SPLIT_LEVELS))
+  {
+    if (!Split_child && (clock >= SIM_TIME))
+      set(converged);
+    return;
+  }
+
+  // Entered the next level: a copy at the top is done
+  Split_level++;
+  Split->Enter[Split_level] += Split_weight;
+  if (Split_level == SPLIT_LEVELS)
+  {
+    if (Split_child)
+      _exit(0);
+    return;
+  }
 
-  return(rv);
+  // About one copy should go on to the next level
+  r = 2.0;
+  if (Split->Enter[Split_level + 1] > 0.0)
+    r = floor(Split->Enter[Split_level] / Split->Enter[Split_level + 1] + 0.5);
+  if (r < 1.0)
+    r = 1.0;
+  if (r > SPLIT_RMAX)
+    r = SPLIT_RMAX;
+  Split_weight /= r;
+
+  // Run each other copy to its end before this one goes on
+  for (j=1; j<(int) r; j++)
+  {
+    fflush(NULL);
+    pid = fork();
+    if (pid < 0)
+    {
+      fprintf(stderr, "ERROR in forking a splitting copy \n");
+      exit(1);
+    }
+    if (pid == 0)
+    {
+      Split_child = 1;
+      Split->Copies++;
+      setup_arrival(&Arrival_dist, lambda);
+      setup_service(&Service_dist, mu);
+      init_pstream(&Arrival_stream, Seed, Split->Copies, ARRIVAL_COMP);
+      init_pstream(&Service_stream, Seed, Split->Copies, SERVICE_COMP);
+      init_pstream(&Policy_stream, Seed, Split->Copies, POLICY_COMP);
+      return;
+    }
+    if ((waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) ||
+        (WEXITSTATUS(status) != 0))
+    {
+      fprintf(stderr, "ERROR splitting copy failed \n");
+      exit(1);
+    }
+  }
+}
+
+//=============================================================================
+//==  Function for the end of a busy cycle: a copy is done; the plain run    ==
+//==  adds the cycle's weighted overflows and checks the CI                  ==
+//=============================================================================
+void split_empty()
+{
+  if (Split_child)
+    _exit(0);
+
+  stats_add(&Split_obs, Split->Enter[SPLIT_LEVELS] - Split_top);
+  if ((Split_obs.N >= SPLIT_MIN) && (stats_mean(&Split_obs) > 0.0) &&
+      (stats_half_width(&Split_obs, 0.95) <=
+         SPLIT_ACC * stats_mean(&Split_obs)))
+    set(converged);
 }
+#endif
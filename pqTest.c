@@ -0,0 +1,91 @@
+//***************************************************//
+// filename: pqTest.c
+// Description: An application to test the PQueue ADT
+//**************************************************//
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "QueueInterface.h"
+
+int main()
+{
+  PQueue P;       //A priority queue variable P
+  double keys[6] = {4.6, 5.7, 5.3, 8.3, 0.5, 2.2};
+  int    handle[6];
+  double f;
+  double last;
+  int    *seen;      // Rounds in which each handle was given out
+  int    capacity;
+  int    errors = 0;
+  int    round;
+  int    i;
+
+  printf("\n\t\t--- PQueue ADT Test ---\n\n");
+
+  // Start small so the heap has to grow
+  InitializePQ(&P, 2);
+
+  for (i=0; i<6; i++)
+    handle[i] = InsertPQ(keys[i], &P);
+
+  printf("Min P: %f\n", MinPQ(&P));
+  printf("Sum P: %f\n\n", SumPQ(&P));
+
+  // SRPT style: shrink the remaining work of the 8.3 job below everything
+  DecreaseKey(handle[3], 0.1, &P);
+  printf("Min P after DecreaseKey: %f\n", MinPQ(&P));
+  printf("Sum P after DecreaseKey: %f\n\n", SumPQ(&P));
+  if (MinPQ(&P) != 0.1 || fabs(SumPQ(&P) - 18.4) > 1e-12)
+    errors++;
+
+  // Keys must come out in non-decreasing order
+  last = 0.0;
+  while (!PQEmpty(&P))
+  {
+    RemoveMin(&P, &f);
+    printf("RemoveMin: %f  Sum P: %f\n", f, SumPQ(&P));
+    if (f < last)
+      errors++;
+    last = f;
+  }
+
+  // Grow well past the starting size: handles stay valid, order holds
+  for (i=0; i<1000; i++)
+  {
+    handle[0] = InsertPQ((double)(1000 - i), &P);
+    if (handle[0] < 0 || handle[0] >= P.Capacity)
+      errors++;
+  }
+  for (i=0; i<1000; i++)
+  {
+    RemoveMin(&P, &f);
+    if (f != (double)(i + 1))
+      errors++;
+  }
+
+  // Refilling to the grown size reuses every freed handle and never grows
+  capacity = P.Capacity;
+  seen = (int *) calloc(capacity, sizeof(int));
+  for (round=1; round<=3; round++)
+  {
+    for (i=0; i<capacity; i++)
+    {
+      handle[0] = InsertPQ((double)(capacity - i), &P);
+      if (handle[0] < 0 || handle[0] >= capacity || seen[handle[0]] != round - 1)
+        errors++;
+      else
+        seen[handle[0]] = round;
+    }
+    while (!PQEmpty(&P))
+      RemoveMin(&P, &f);
+    if (P.Capacity != capacity)
+      errors++;
+  }
+  printf("Capacity after %d refills: %d (was %d)\n", round - 1, P.Capacity,
+         capacity);
+  free(seen);
+
+  printf("\nErrors: %d\n", errors);
+  FreePQ(&P);
+  return (errors != 0);
+}
@@ -0,0 +1,127 @@
+//***************************************************//
+// filename: repTest.c
+// Description: An application to test run_replications() and
+//              run_replications_forked()
+//**************************************************//
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "StreamInterface.h"
+#include "StatsInterface.h"
+#include "ReplicationInterface.h"
+
+#define NUM_MAX  400
+#define NUM_DRAW 20000
+
+long Warm = 0;    // State each forked observation must start from
+
+typedef struct {
+  STATS Obs;
+  long  Expect;   // Next index merge() should see
+  int   Errors;
+} STATE;
+
+// Observation i: mean and variance of NUM_DRAW * (1 + i % 5) uniforms from
+// substream i, so the workers finish out of order
+void run(long index, double *out, void *arg)
+{
+  PHILOX s;
+  STATS  st;
+  long   i;
+
+  (void) arg;
+  init_pstream(&s, 7, index, 0);
+  stats_reset(&st);
+  for (i=0; i<NUM_DRAW * (1 + index % 5); i++)
+    stats_add(&st, pstream_uniform01(&s));
+  out[0] = stats_mean(&st);
+  out[1] = stats_var(&st);
+}
+
+// The same observation, but it must see the caller's state and spoils it
+void run_warm(long index, double *out, void *arg)
+{
+  run(index, out, arg);
+  if (Warm != 12345)
+    out[1] = -1.0;
+  Warm = -1;
+}
+
+int merge(long index, const double *out, void *arg)
+{
+  STATE *st = (STATE *) arg;
+
+  if ((index != st->Expect) || (out[1] <= 0.0))
+    st->Errors++;
+  st->Expect++;
+  stats_add(&st->Obs, out[0]);
+  return (st->Obs.N >= 10) &&
+         (stats_half_width(&st->Obs, 0.95) < 0.001 * stats_mean(&st->Obs));
+}
+
+int main()
+{
+  STATE  one;
+  STATE  par;
+  long   n1, n4;
+  int    errors = 0;
+
+  printf("\n\t\t--- Replication Test ---\n\n");
+
+  one.Expect = 0;
+  one.Errors = 0;
+  stats_reset(&one.Obs);
+  n1 = run_replications(1, 0, NUM_MAX, 2, run, merge, &one);
+
+  par.Expect = 0;
+  par.Errors = 0;
+  stats_reset(&par.Obs);
+  n4 = run_replications(4, 0, NUM_MAX, 2, run, merge, &par);
+
+  printf("1 process:   %ld observations, mean %.10f\n", n1, stats_mean(&one.Obs));
+  printf("4 processes: %ld observations, mean %.10f\n", n4, stats_mean(&par.Obs));
+
+  // The stopping point and estimate must not depend on the worker count
+  if ((n1 <= 10) || (n1 >= NUM_MAX) || (n4 != n1) ||
+      (stats_mean(&par.Obs) != stats_mean(&one.Obs)))
+    errors++;
+  errors += one.Errors + par.Errors;
+
+  // Forked from the caller's state: same answer, and the state survives
+  par.Expect = 0;
+  par.Errors = 0;
+  stats_reset(&par.Obs);
+  Warm = 12345;
+  n4 = run_replications_forked(3, 0, NUM_MAX, 2, run_warm, merge, &par);
+  printf("3 forked:    %ld observations, mean %.10f\n", n4, stats_mean(&par.Obs));
+  if ((n4 != n1) || (stats_mean(&par.Obs) != stats_mean(&one.Obs)) ||
+      (Warm != 12345))
+    errors++;
+  errors += par.Errors;
+
+  // Resumed after 6 observations (as from a checkpoint): same answer
+  par.Expect = 0;
+  par.Errors = 0;
+  stats_reset(&par.Obs);
+  if (run_replications(1, 0, 6, 2, run, merge, &par) != 6)
+    errors++;
+  n4 = run_replications(4, 6, NUM_MAX, 2, run, merge, &par);
+  printf("Resumed:     %ld observations, mean %.10f\n", n4, stats_mean(&par.Obs));
+  if ((n4 != n1) || (stats_mean(&par.Obs) != stats_mean(&one.Obs)))
+    errors++;
+  errors += par.Errors;
+
+  // merge() never stopping runs all of them
+  par.Expect = 0;
+  stats_reset(&par.Obs);
+  if (run_replications(3, 0, 7, 2, run, merge, &par) != 7)
+    errors++;
+  par.Expect = 0;
+  stats_reset(&par.Obs);
+  if (run_replications_forked(1, 0, 7, 2, run_warm, merge, &par) != 7)
+    errors++;
+  errors += par.Errors;
+
+  printf("\nErrors: %d\n", errors);
+  return (errors != 0);
+}
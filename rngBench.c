@@ -0,0 +1,513 @@
+//=================================================== file = rngBench.c =====
+//=  Program to benchmark the random variate generators used by the models  =
+//===========================================================================
+//=  Notes: 1) Each generator fills -n values from seed -s, timed (ns per   =
+//=            variate, including the store), then the values are turned    =
+//=            into uniforms by their survival function and tested:         =
+//=             * KS       = Kolmogorov-Smirnov against the target cdf      =
+//=             * chi2     = equidistribution over 1024 cells               =
+//=             * serial   = non-overlapping pairs over 64 x 64 cells       =
+//=             * lag-1    = serial correlation of successive values        =
+//=             * bday     = 2-D birthday spacings (the SmallCrush test     =
+//=                          that catches LCG lattices): n/2 points with    =
+//=                          about 8 expected collisions                    =
+//=            A p-value below 0.001 (or above 0.999 for the chi-square     =
+//=            tests) is flagged with *                                     =
+//=         2) Generators are listed as dist/name:                          =
+//=             * jain        = rand_val() from genpar2.c (MINSTD)          =
+//=             * philox      = one pstream_uniform01() per variate         =
+//=             * philox-fill = block fill (pstream_fill_*, dist_sample)    =
+//=             * philox-inv  = exponential by inversion (EXPO_DIST)        =
+//=             * philox-zig  = exponential by ziggurat (ZIG_EXPO_DIST)     =
+//=             * philox-rv   = bpareto_rv(), one libm pow per variate      =
+//=             * csim        = CSIM stream_uniform01/stream_exponential    =
+//=                             (only when built with -DBENCH_CSIM)         =
+//=            bpar is bounded Pareto(1.985, 0.5, 100) as in the models     =
+//=         3) -g keeps the generators whose dist/name contains its         =
+//=            argument (e.g. -g bpar, -g zig)                              =
+//=-------------------------------------------------------------------------=
+//= Example execution:                                                      =
+//=                                                                         =
+//=   rngBench -g unif                                                      =
+//=   ---------------------------------------- rngBench.c ----              =
+//=   -  4194304 values per generator, seed 1                               =
+//=   --------------------------------------------------------              =
+//=   -  generator           ns/var     KS    chi2  serial   lag-1    bday  =
+//=   -  unif/jain            11.32 0.3291  0.9124  0.2241  0.5858  0.0000* =
+//=   -  unif/philox          20.68 0.9434  0.4376  0.3410  0.0819  0.6866  =
+//=   -  unif/philox-fill      8.92 0.9434  0.4376  0.3410  0.0819  0.6866  =
+//=   --------------------------------------------------------              =
+//=-------------------------------------------------------------------------=
+//=  Build: gcc -O2 -mavx2 rngBench.c DistributionImplementation.c          =
+//=             StreamImplementation.c StatsImplementation.c -lm            =
+//=         (add -DBENCH_CSIM and the standard CSIM build for csim rows)    =
+//=-------------------------------------------------------------------------=
+//=  Execute: rngBench [-n values] [-s seed] [-g filter]                    =
+//===========================================================================
+//----- Include files -------------------------------------------------------
+#include <stdio.h>            // Needed for printf()
+#include <stdlib.h>           // Needed for exit(), ato*() and qsort()
+#include <string.h>           // Needed for strstr() and memset()
+#include <math.h>             // Needed for log(), pow() and erfc()
+#include <time.h>             // Needed for clock_gettime()
+#include <unistd.h>           // Needed for getopt()
+#include "StreamInterface.h"        // Needed for PHILOX
+#include "DistributionInterface.h"  // Needed for dist_sample()
+#include "StatsInterface.h"         // Needed for chi2_sf() and ks_sf()
+#ifdef BENCH_CSIM
+#include "csim.h"                   // Needed for stream_uniform01()
+#endif
+
+//----- Constants -----------------------------------------------------------
+#define NUM_VALUES  (1L << 22)   // Default values per generator
+#define CHI_CELLS   1024         // Cells of the equidistribution test
+#define SER_CELLS   64           // Cells per axis of the serial test
+#define P_SUSPECT   0.001        // Flag p-values beyond this
+#define BPAR_A      1.985        // Bounded Pareto as in the models
+#define BPAR_K      0.5
+#define BPAR_P      100.0
+
+//----- Types ---------------------------------------------------------------
+typedef enum { UNIF, EXPO, BPAR } TARGET;
+
+typedef struct {
+  const char *Name;           // dist/name
+  TARGET     Target;          // Distribution generated
+  void       (*Fill)(double *x, long n);
+} GENERATOR;
+
+//----- Globals -------------------------------------------------------------
+long          Seed = 1;       // Seed for every generator
+PHILOX        Stream;         // Philox stream
+EXPO_DIST     Expo;           // Exponential by inversion
+ZIG_EXPO_DIST Zig;            // Exponential by ziggurat
+BPAR_DIST     Bpar;           // Bounded Pareto, block filled
+BPAR_PARAMS   Par;            // Bounded Pareto constants
+#ifdef BENCH_CSIM
+STREAM        Csim_stream;    // CSIM stream
+#endif
+
+//----- Function prototypes -------------------------------------------------
+double rand_val(int seed);                    // Jain's RNG (genpar2.c)
+double bpareto(double a, double k, double p); // Bounded Pareto (genpar2.c)
+void   reset_generators(void);                // Reseed every generator
+void   usage(void);                           // Print the option summary
+void   to_uniform(TARGET target, const double *x, double *u, long n);
+double ks_p(const double *u, long n);
+double chi2_p(const double *u, long n);
+double serial_p(const double *u, long n);
+double lag1_p(const double *u, long n);
+double bday_p(const double *u, long n);
+int    bench(int argc, char *argv[]);
+
+//----- Generators ----------------------------------------------------------
+void unif_jain(double *x, long n)
+{
+  long i;
+  for (i=0; i<n; i++) x[i] = rand_val(0);
+}
+
+void unif_philox(double *x, long n)
+{
+  long i;
+  for (i=0; i<n; i++) x[i] = pstream_uniform01(&Stream);
+}
+
+void unif_philox_fill(double *x, long n)
+{
+  pstream_fill_uniform01(&Stream, x, n);
+}
+
+void expo_jain(double *x, long n)
+{
+  long i;
+  for (i=0; i<n; i++) x[i] = -log(rand_val(0));
+}
+
+void expo_philox_inv(double *x, long n)
+{
+  long i;
+  for (i=0; i<n; i++) x[i] = dist_sample(&Expo, &Stream);
+}
+
+void expo_philox_zig(double *x, long n)
+{
+  long i;
+  for (i=0; i<n; i++) x[i] = dist_sample(&Zig, &Stream);
+}
+
+void bpar_jain(double *x, long n)
+{
+  long i;
+  for (i=0; i<n; i++) x[i] = bpareto(BPAR_A, BPAR_K, BPAR_P);
+}
+
+void bpar_philox_rv(double *x, long n)
+{
+  long i;
+  for (i=0; i<n; i++) x[i] = bpareto_rv(&Par, pstream_uniform01(&Stream));
+}
+
+void bpar_philox_fill(double *x, long n)
+{
+  long i;
+  for (i=0; i<n; i++) x[i] = dist_sample(&Bpar, &Stream);
+}
+
+#ifdef BENCH_CSIM
+void unif_csim(double *x, long n)
+{
+  long i;
+  for (i=0; i<n; i++) x[i] = stream_uniform01(Csim_stream);
+}
+
+void expo_csim(double *x, long n)
+{
+  long i;
+  for (i=0; i<n; i++) x[i] = stream_exponential(Csim_stream, 1.0);
+}
+
+void bpar_csim(double *x, long n)
+{
+  long i;
+  for (i=0; i<n; i++) x[i] = bpareto_rv(&Par, stream_uniform01(Csim_stream));
+}
+#endif
+
+GENERATOR Gen[] = {
+  {"unif/jain",         UNIF, unif_jain},
+  {"unif/philox",       UNIF, unif_philox},
+  {"unif/philox-fill",  UNIF, unif_philox_fill},
+#ifdef BENCH_CSIM
+  {"unif/csim",         UNIF, unif_csim},
+#endif
+  {"expo/jain",         EXPO, expo_jain},
+  {"expo/philox-inv",   EXPO, expo_philox_inv},
+  {"expo/philox-zig",   EXPO, expo_philox_zig},
+#ifdef BENCH_CSIM
+  {"expo/csim",         EXPO, expo_csim},
+#endif
+  {"bpar/jain",         BPAR, bpar_jain},
+  {"bpar/philox-rv",    BPAR, bpar_philox_rv},
+  {"bpar/philox-fill",  BPAR, bpar_philox_fill},
+#ifdef BENCH_CSIM
+  {"bpar/csim",         BPAR, bpar_csim},
+#endif
+};
+#define NUM_GEN ((int) (sizeof(Gen) / sizeof(Gen[0])))
+
+//===== Main program ========================================================
+#ifdef BENCH_CSIM
+void sim(int argc, char *argv[])   // CSIM supplies main()
+{
+  exit(bench(argc, argv));
+}
+#else
+int main(int argc, char *argv[])
+{
+  return(bench(argc, argv));
+}
+#endif
+
+int bench(int argc, char *argv[])
+{
+  long     num_values = NUM_VALUES; // Values per generator
+  char     *filter = NULL;     // Substring of the generators to run
+  double   *x;                 // Generated values
+  double   *u;                 // Their survival probabilities
+  double   p[5];               // p-values
+  double   secs;               // Time to generate
+  struct timespec t0, t1;      // Start and end times
+  int      two_sided[5] = {0, 1, 1, 0, 0}; // Flag high p too (chi-square)
+  int      c;                  // Option character
+  int      g, j;               // Loop counters
+
+  while ((c = getopt(argc, argv, "n:s:g:")) != -1)
+  {
+    switch (c)
+    {
+      case 'n': num_values = atol(optarg); break;
+      case 's': Seed = atol(optarg); break;
+      case 'g': filter = optarg; break;
+      default: usage();
+    }
+  }
+  if ((num_values < 2 * SER_CELLS * SER_CELLS) || (Seed <= 0))
+    usage();
+
+  x = (double *) malloc(num_values * sizeof(double));
+  u = (double *) malloc(num_values * sizeof(double));
+  if ((x == NULL) || (u == NULL))
+  {
+    printf("ERROR in allocating %ld values \n", num_values);
+    exit(1);
+  }
+  memset(x, 0, num_values * sizeof(double));
+  memset(u, 0, num_values * sizeof(double));
+  setup_bpareto(BPAR_A, BPAR_K, BPAR_P, &Par);
+#ifdef BENCH_CSIM
+  Csim_stream = create_stream();
+#endif
+
+  printf("---------------------------------------- rngBench.c ---- \n");
+  printf("-  %ld values per generator, seed %ld \n", num_values, Seed);
+  printf("-------------------------------------------------------- \n");
+  printf("-  generator           ns/var     KS    chi2  serial   lag-1    bday \n");
+  for (g=0; g<NUM_GEN; g++)
+  {
+    if ((filter != NULL) && (strstr(Gen[g].Name, filter) == NULL))
+      continue;
+
+    reset_generators();
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    Gen[g].Fill(x, num_values);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    secs = (t1.tv_sec - t0.tv_sec) + 1.0e-9 * (t1.tv_nsec - t0.tv_nsec);
+
+    to_uniform(Gen[g].Target, x, u, num_values);
+    p[0] = ks_p(u, num_values);
+    p[1] = chi2_p(u, num_values);
+    p[2] = serial_p(u, num_values);
+    p[3] = lag1_p(u, num_values);
+    p[4] = bday_p(u, num_values);
+
+    printf("-  %-18s %7.2f", Gen[g].Name, 1.0e9 * secs / num_values);
+    for (j=0; j<5; j++)
+    {
+      printf(" %6.4f%c", p[j],
+        ((p[j] < P_SUSPECT) || (two_sided[j] && (p[j] > 1.0 - P_SUSPECT)))
+        ? '*' : ' ');
+    }
+    printf("\n");
+  }
+  printf("-------------------------------------------------------- \n");
+
+  free(x);
+  free(u);
+  return(0);
+}
+
+//===========================================================================
+//=  Function to put every generator back at the start of seed Seed         =
+//===========================================================================
+void reset_generators(void)
+{
+  rand_val((int) Seed);
+  init_pstream(&Stream, Seed, 0, 0);
+  setup_expo(1.0, &Expo);
+  setup_zig_expo(1.0, &Zig);
+  setup_bpar_dist(BPAR_A, BPAR_K, BPAR_P, &Bpar);
+#ifdef BENCH_CSIM
+  reseed(Csim_stream, Seed);
+#endif
+}
+
+//===========================================================================
+//=  Function to print the option summary and exit                          =
+//===========================================================================
+void usage(void)
+{
+  fprintf(stderr, "Usage: rngBench [-n values] [-s seed] [-g filter] \n");
+  fprintf(stderr, "       (values >= %d, seed > 0) \n",
+    2 * SER_CELLS * SER_CELLS);
+  exit(1);
+}
+
+//===========================================================================
+//=  Function to map values to uniforms by the target survival function     =
+//===========================================================================
+void to_uniform(TARGET target, const double *x, double *u, long n)
+{
+  long i;     // Loop counter
+
+  for (i=0; i<n; i++)
+  {
+    if (target == UNIF)
+      u[i] = x[i];
+    else if (target == EXPO)
+      u[i] = exp(-x[i]);
+    else
+      u[i] = (pow(BPAR_K / x[i], BPAR_A) - Par.D) / (1.0 - Par.D);
+  }
+}
+
+//===========================================================================
+//=  Functions for the tests; each returns the p-value of its statistic     =
+//===========================================================================
+static int cmp_double(const void *a, const void *b)
+{
+  double x = *(const double *) a;
+  double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *) a;
+  uint64_t y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+double ks_p(const double *u, long n)
+{
+  double *s;            // Sorted copy of u
+  double d = 0.0;       // KS statistic
+  long   i;
+
+  s = (double *) malloc(n * sizeof(double));
+  if (s == NULL)
+    return -1.0;
+  memcpy(s, u, n * sizeof(double));
+  qsort(s, n, sizeof(double), cmp_double);
+  for (i=0; i<n; i++)
+  {
+    if ((double) (i + 1) / n - s[i] > d) d = (double) (i + 1) / n - s[i];
+    if (s[i] - (double) i / n > d) d = s[i] - (double) i / n;
+  }
+  free(s);
+  return ks_sf(d, n);
+}
+
+double chi2_p(const double *u, long n)
+{
+  long   cnt[CHI_CELLS] = {0};
+  double e = (double) n / CHI_CELLS;
+  double chi = 0.0;
+  long   i;
+  int    j;
+
+  for (i=0; i<n; i++)
+  {
+    j = (int) (u[i] * CHI_CELLS);
+    cnt[(j < CHI_CELLS) ? j : CHI_CELLS - 1]++;
+  }
+  for (j=0; j<CHI_CELLS; j++)
+    chi += (cnt[j] - e) * (cnt[j] - e) / e;
+  return chi2_sf(chi, CHI_CELLS - 1);
+}
+
+double serial_p(const double *u, long n)
+{
+  static long cnt[SER_CELLS * SER_CELLS];
+  long   m = n / 2;
+  double e = (double) m / (SER_CELLS * SER_CELLS);
+  double chi = 0.0;
+  long   i;
+  int    a, b;
+
+  memset(cnt, 0, sizeof(cnt));
+  for (i=0; i<m; i++)
+  {
+    a = (int) (u[2 * i] * SER_CELLS);
+    b = (int) (u[2 * i + 1] * SER_CELLS);
+    if (a == SER_CELLS) a--;
+    if (b == SER_CELLS) b--;
+    cnt[a * SER_CELLS + b]++;
+  }
+  for (a=0; a<SER_CELLS * SER_CELLS; a++)
+    chi += (cnt[a] - e) * (cnt[a] - e) / e;
+  return chi2_sf(chi, SER_CELLS * SER_CELLS - 1);
+}
+
+double lag1_p(const double *u, long n)
+{
+  double num = 0.0;     // Lag-1 cross products
+  double den = 0.0;     // Sum of squares
+  long   i;
+
+  for (i=0; i<n; i++)
+  {
+    den += (u[i] - 0.5) * (u[i] - 0.5);
+    if (i > 0)
+      num += (u[i] - 0.5) * (u[i - 1] - 0.5);
+  }
+  return erfc(fabs(num / den) * sqrt((double) n) / sqrt(2.0));
+}
+
+double bday_p(const double *u, long n)
+{
+  uint64_t *day;        // Birthdays, then their spacings
+  long     m = n / 2;   // Points
+  int      lg = 0;      // floor(log2(m))
+  int      bits;        // Bits per coordinate
+  double   lambda;      // Expected collisions
+  long     y = 0;       // Collisions
+  long     i;
+
+  while ((2L << lg) <= m)
+    lg++;
+  bits = (3 * lg - 5) / 2;
+  if (bits > 31)
+    bits = 31;
+  lambda = pow((double) m, 3.0) / (4.0 * pow(2.0, 2.0 * bits));
+
+  day = (uint64_t *) malloc(m * sizeof(uint64_t));
+  if (day == NULL)
+    return -1.0;
+  for (i=0; i<m; i++)
+    day[i] = ((uint64_t) (u[2 * i] * (double) (1L << bits)) << bits) |
+              (uint64_t) (u[2 * i + 1] * (double) (1L << bits));
+  qsort(day, m, sizeof(uint64_t), cmp_u64);
+  for (i=m-1; i>0; i--)
+    day[i] -= day[i - 1];
+  qsort(day + 1, m - 1, sizeof(uint64_t), cmp_u64);
+  for (i=2; i<m; i++)
+    if (day[i] == day[i - 1])
+      y++;
+  free(day);
+
+  // P(Poisson(lambda) >= y) = P(chi-square(2y) <= 2 lambda)
+  return (y == 0) ? 1.0 : 1.0 - chi2_sf(2.0 * lambda, 2 * y);
+}
+
+//===========================================================================
+//=  Bounded Pareto and RNG from genpar2.c, kept as the baseline            =
+//===========================================================================
+double bpareto(double a, double k, double p)
+{
+  double z;     // Uniform random number from 0 to 1
+  double rv;    // RV to be returned
+
+  // Pull a uniform RV (0 < z < 1)
+  do
+  {
+    z = rand_val(0);
+  }
+  while ((z == 0) || (z == 1));
+
+  // Generate the bounded Pareto rv using the inversion method
+  rv = pow((pow(k, a) / (z*pow((k/p), a) - z + 1)), (1.0/a));
+
+  return(rv);
+}
+
+double rand_val(int seed)
+{
+  const long  a =      16807;  // Multiplier
+  const long  m = 2147483647;  // Modulus
+  const long  q =     127773;  // m div a
+  const long  r =       2836;  // m mod a
+  static long x;               // Random int value
+  long        x_div_q;         // x divided by q
+  long        x_mod_q;         // x modulo q
+  long        x_new;           // New x value
+
+  // Set the seed if argument is non-zero and then return zero
+  if (seed > 0)
+  {
+    x = seed;
+    return(0.0);
+  }
+
+  // RNG using integer arithmetic
+  x_div_q = x / q;
+  x_mod_q = x % q;
+  x_new = (a * x_mod_q) - (r * x_div_q);
+  if (x_new > 0)
+    x = x_new;
+  else
+    x = x_new + m;
+
+  // Return a random value between 0.0 and 1.0
+  return((double) x / m);
+}
@@ -0,0 +1,207 @@
+//***************************************************//
+// filename: statsTest.c
+// Description: An application to test the STATS, CV_STATS, RATIO_STATS, MSER,
+//              HDR and TDIGEST ADTs
+//**************************************************//
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "StreamInterface.h"
+#include "StatsInterface.h"
+
+#define NUM_TRIALS 2000
+#define NUM_OBS    20
+#define MSER_OBS   200000
+#define HDR_OBS    100000
+#define TD_OBS     1000000
+#define TD_PARTS   5
+
+static int cmp_double(const void *a, const void *b)
+{
+  double x = *(const double *) a;
+  double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+int main()
+{
+  // Student-t quantiles from the tables (two-sided 95% and 99%)
+  long     df[5] = {1, 2, 5, 19, 120};
+  double   t95[5] = {12.7062, 4.3027, 2.5706, 2.0930, 1.9799};
+  double   t99[5] = {63.6567, 9.9248, 4.0321, 2.8609, 2.6174};
+  double   x[5] = {2.0, 4.0, 4.0, 5.0, 7.0};
+  double   mu[2] = {0.5, 0.0};
+  double   c[2];
+  double   beta[CV_MAX];
+  double   y, e;
+  STATS    st;
+  STATS    raw;
+  CV_STATS cv;
+  RATIO_STATS rs;
+  MSER     m;
+  static HDR h, h2;      // Too big for the stack
+  double   p[3] = {0.5, 0.99, 0.999};
+  static TDIGEST td[TD_PARTS];
+  double   *all;
+  long     d;
+  PSTREAM  s;
+  int      covered = 0;
+  int      errors = 0;
+  int      i, j;
+
+  printf("\n\t\t--- STATS ADT Test ---\n\n");
+
+  for (i=0; i<5; i++)
+  {
+    if ((fabs(t_quantile(0.975, df[i]) - t95[i]) > 1.0e-4) ||
+        (fabs(t_quantile(0.995, df[i]) - t99[i]) > 1.0e-4))
+      errors++;
+  }
+  printf("t(0.975, 19) = %f\n", t_quantile(0.975, 19));
+
+  // Welford mean and variance of 2 4 4 5 7
+  stats_reset(&st);
+  for (i=0; i<5; i++)
+    stats_add(&st, x[i]);
+  if ((fabs(stats_mean(&st) - 4.4) > 1.0e-12) ||
+      (fabs(stats_var(&st) - 3.3) > 1.0e-12))
+    errors++;
+
+  // y = 1 + 3c + e, c uniform (mean 0.5), e uniform(-0.5, 0.5): the control
+  // removes most of the variance and the CI must still cover E[y] = 2.5
+  s = create_pstream(2009, 0, 0);
+  for (i=0; i<NUM_TRIALS; i++)
+  {
+    cv_reset(&cv, 1, mu);
+    for (j=0; j<NUM_OBS; j++)
+    {
+      c[0] = pstream_uniform01(s);
+      e = pstream_uniform01(s) - 0.5;
+      cv_add(&cv, 1.0 + 3.0 * c[0] + e, c);
+    }
+    if (fabs(cv_mean(&cv) - 2.5) <= cv_half_width(&cv, 0.95))
+      covered++;
+  }
+  cv_raw(&cv, &raw);
+  cv_beta(&cv, beta);
+  printf("Last trial: raw %f +/- %f, adjusted %f +/- %f, beta %f\n",
+    stats_mean(&raw), stats_half_width(&raw, 0.95),
+    cv_mean(&cv), cv_half_width(&cv, 0.95), beta[0]);
+  printf("CV coverage: %d of %d\n", covered, NUM_TRIALS);
+  if ((covered < 0.93 * NUM_TRIALS) || (covered > 0.97 * NUM_TRIALS))
+    errors++;
+  if (cv_half_width(&cv, 0.95) > 0.5 * stats_half_width(&raw, 0.95))
+    errors++;
+
+  // A constant control is collinear: fall back to the raw estimate
+  mu[1] = 1.0;
+  cv_reset(&cv, 2, mu);
+  for (j=0; j<NUM_OBS; j++)
+  {
+    c[0] = pstream_uniform01(s);
+    c[1] = 1.0;
+    y = pstream_uniform01(s);
+    cv_add(&cv, y, c);
+  }
+  cv_raw(&cv, &raw);
+  if ((cv_beta(&cv, beta) != -1) || (cv_mean(&cv) != stats_mean(&raw)) ||
+      (cv_half_width(&cv, 0.95) != stats_half_width(&raw, 0.95)))
+    errors++;
+
+  // Cycles of x ~ 1 + uniform customers with y = x draws of uniform(0, 2)
+  // each: the ratio is 1, and the CI must cover it
+  covered = 0;
+  for (i=0; i<NUM_TRIALS; i++)
+  {
+    ratio_reset(&rs);
+    for (j=0; j<NUM_OBS; j++)
+    {
+      c[0] = 1.0 + (int) (4.0 * pstream_uniform01(s));
+      for (y=0.0, e=0.0; e<c[0]; e+=1.0)
+        y += 2.0 * pstream_uniform01(s);
+      ratio_add(&rs, y, c[0]);
+    }
+    if (fabs(ratio_mean(&rs) - 1.0) <= ratio_half_width(&rs, 0.95))
+      covered++;
+  }
+  printf("Ratio coverage: %d of %d\n", covered, NUM_TRIALS);
+  if ((covered < 0.92 * NUM_TRIALS) || (covered > 0.97 * NUM_TRIALS))
+    errors++;
+
+  // Noise after a decaying transient: truncate past most of the transient
+  // but well short of half the run, in bounded memory
+  mser_reset(&m);
+  for (i=0; i<MSER_OBS; i++)
+    mser_add(&m, 20.0 * exp(-i / 2000.0) + pstream_uniform01(s));
+  d = mser_truncation(&m);
+  printf("MSER-5: truncate %ld of %ld (%d batches of %ld)\n",
+    d, m.N, m.Count, m.Size);
+  if ((d < 10000) || (d > 40000) || (m.Count > MSER_MAX))
+    errors++;
+
+  // Growing without bound: never warm
+  mser_reset(&m);
+  for (i=0; i<MSER_OBS; i++)
+    mser_add(&m, i + pstream_uniform01(s));
+  if (mser_truncation(&m) != -1)
+    errors++;
+
+  // 0.001, 0.002, ... recorded into two histograms and merged: every
+  // percentile within the bucket bound of the exact order statistic
+  hdr_reset(&h);
+  hdr_reset(&h2);
+  for (i=1; i<=HDR_OBS; i++)
+    hdr_record((i % 2) ? &h : &h2, 0.001 * i);
+  hdr_merge(&h, &h2);
+  for (i=0; i<3; i++)
+  {
+    y = 0.001 * ceil(p[i] * HDR_OBS);
+    printf("HDR p%g: %f (exact %f)\n", 100.0 * p[i], hdr_percentile(&h, p[i]),
+      y);
+    if ((h.N != HDR_OBS) ||
+        (fabs(hdr_percentile(&h, p[i]) - y) > y / (2 << HDR_SUB_BITS)))
+      errors++;
+  }
+
+  // Out of range values land in the end buckets
+  hdr_reset(&h);
+  hdr_record(&h, 0.0);
+  hdr_record(&h, 1.0e9);
+  if ((hdr_percentile(&h, 0.5) > ldexp(1.0, HDR_MIN_EXP + 1)) ||
+      (hdr_percentile(&h, 1.0) < ldexp(1.0, HDR_MAX_EXP - 1)))
+    errors++;
+
+  // Exponential values dealt to TD_PARTS digests (servers, say) and merged:
+  // quantiles within 1% of the exact sample quantiles, in bounded size
+  all = (double *) malloc(TD_OBS * sizeof(double));
+  if (all == NULL)
+    return 1;
+  for (j=0; j<TD_PARTS; j++)
+    td_reset(&td[j]);
+  for (i=0; i<TD_OBS; i++)
+  {
+    all[i] = -log(pstream_uniform01(s));
+    td_add(&td[i % TD_PARTS], all[i]);
+  }
+  for (j=1; j<TD_PARTS; j++)
+    td_merge(&td[0], &td[j]);
+  qsort(all, TD_OBS, sizeof(double), cmp_double);
+  for (i=0; i<3; i++)
+  {
+    y = all[(long) ceil(p[i] * TD_OBS) - 1];
+    printf("t-digest p%g: %f (sample %f), %d centroids\n", 100.0 * p[i],
+      td_quantile(&td[0], p[i]), y, td[0].Count);
+    if ((fabs(td_quantile(&td[0], p[i]) - y) > 0.01 * y) ||
+        (td[0].Total != TD_OBS) || (td[0].Count > TD_CAP))
+      errors++;
+  }
+  if ((td_quantile(&td[0], 0.0) != all[0]) ||
+      (td_quantile(&td[0], 1.0) != all[TD_OBS - 1]))
+    errors++;
+  free(all);
+
+  delete_pstream(s);
+
+  printf("\nErrors: %d\n", errors);
+  return (errors != 0);
+}
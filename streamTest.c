@@ -0,0 +1,140 @@
+//***************************************************//
+// filename: streamTest.c
+// Description: An application to test the PSTREAM ADT
+//**************************************************//
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "StreamInterface.h"
+
+#define NUM_FILL 1003
+
+int main()
+{
+  // Known-answer vectors from the Random123 distribution
+  uint32_t ctr[3][4] = {{0, 0, 0, 0},
+                        {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                        {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+  uint32_t key[3][2] = {{0, 0},
+                        {0xffffffff, 0xffffffff},
+                        {0xa4093822, 0x299f31d0}};
+  uint32_t kat[3][4] = {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+                        {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+                        {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+  uint32_t out[4];
+  double   seq[NUM_FILL];
+  double   blk[NUM_FILL];
+  uint64_t wide[NUM_FILL];
+  PSTREAM  s;
+  PSTREAM  t;
+  uint64_t pos;
+  SOBOL    q;
+  double   pt[3];
+  double   sob[4][3] = {{0.0, 0.0, 0.0}, {0.5, 0.5, 0.5},
+                        {0.75, 0.25, 0.25}, {0.25, 0.75, 0.75}};
+  int      errors = 0;
+  int      i, j;
+
+  printf("\n\t\t--- PSTREAM ADT Test ---\n\n");
+
+  for (i=0; i<3; i++)
+  {
+    philox4x32(ctr[i], key[i], out);
+    printf("KAT %d: %08x %08x %08x %08x\n", i, out[0], out[1], out[2], out[3]);
+    for (j=0; j<4; j++)
+      if (out[j] != kat[i][j])
+        errors++;
+  }
+
+  // Block fill must match one-at-a-time draws, from any starting offset
+  s = create_pstream(12345, 7, 2);
+  t = create_pstream(12345, 7, 2);
+  for (i=0; i<NUM_FILL; i++)
+  {
+    seq[i] = pstream_uniform01(s);
+    if (seq[i] <= 0.0 || seq[i] >= 1.0)
+      errors++;
+  }
+  pstream_next32(t);
+  pstream_seek(t, 0);
+  pstream_fill_uniform01(t, blk, 1);
+  pstream_fill_uniform01(t, blk + 1, NUM_FILL - 1);
+  for (i=0; i<NUM_FILL; i++)
+    if (seq[i] != blk[i])
+      errors++;
+  // From an odd word the uniforms straddle blocks
+  pstream_seek(s, 1);
+  pstream_seek(t, 1);
+  pstream_fill_uniform01(t, blk, NUM_FILL);
+  for (i=0; i<NUM_FILL; i++)
+    if (pstream_uniform01(s) != blk[i])
+      errors++;
+  if (pstream_tell(t) != pstream_tell(s))
+    errors++;
+  pstream_seek(s, 2 * NUM_FILL);
+  printf("\nFill vs sequential: %s\n", errors ? "MISMATCH" : "ok");
+
+  // Bulk 64-bit words pair up the 32-bit words high word first
+  reseed_pstream(t, 99, 0, 0);
+  pstream_next32(t);
+  pstream_fill64(t, wide, NUM_FILL);
+  if (pstream_tell(t) != 1 + 2 * NUM_FILL)
+    errors++;
+  reseed_pstream(t, 99, 0, 0);
+  pstream_next32(t);
+  for (i=0; i<NUM_FILL; i++)
+  {
+    pos = (uint64_t)pstream_next32(t) << 32;
+    pos = pos | pstream_next32(t);
+    if (wide[i] != pos)
+      errors++;
+  }
+
+  // Jump ahead lands on the same value as stepping there
+  pos = pstream_tell(s);
+  printf("Position after %d draws: %lu words\n", NUM_FILL, (unsigned long)pos);
+  if (pos != 2 * NUM_FILL)
+    errors++;
+  reseed_pstream(t, 12345, 7, 2);
+  pstream_seek(t, 2 * 500 + 2);
+  if (pstream_uniform01(t) != seq[501])
+    errors++;
+
+  // Neighbouring substreams must not overlap
+  reseed_pstream(t, 12345, 8, 2);
+  if (pstream_uniform01(t) == seq[0])
+    errors++;
+
+  // Antithetic draws are exactly 1 - u, sequential or filled
+  reseed_pstream(t, 12345, 7, 2);
+  pstream_antithetic(t, 1);
+  pstream_fill_uniform01(t, blk, NUM_FILL);
+  for (i=0; i<NUM_FILL; i++)
+    if (blk[i] != 1.0 - seq[i])
+      errors++;
+  // Turning it on mid-block also flips the words already generated
+  reseed_pstream(t, 12345, 7, 2);
+  if (pstream_next32(t) != (uint32_t)(seq[0] * 4294967296.0))
+    errors++;
+  pstream_next32(t);
+  pstream_antithetic(t, 1);
+  if (pstream_uniform01(t) != 1.0 - seq[1])
+    errors++;
+
+  // Unshifted Sobol points 1..3 of dimensions 1-3 (Joe-Kuo)
+  init_sobol(&q, 3, NULL);
+  for (i=0; i<4; i++)
+  {
+    sobol_next(&q, pt);
+    for (j=0; j<3; j++)
+      if (fabs(pt[j] - sob[i][j]) > 1.0e-9)
+        errors++;
+  }
+  printf("Sobol point 3: %f %f %f\n", pt[0], pt[1], pt[2]);
+
+  delete_pstream(s);
+  delete_pstream(t);
+
+  printf("\nErrors: %d\n", errors);
+  return (errors != 0);
+}
@@ -0,0 +1,946 @@
+//====================================================== file = sweep.c =====
+//=  Program to sweep the load balancing models over load, delay and seed   =
+//===========================================================================
+//=  Notes: 1) Each model is a binary of load_balancing_csim.c (one per     =
+//=            policy); every combination of model, -l load, -d delay and   =
+//=            -s seed is one run: model -p procs [-s seed] load [delay]    =
+//=         2) -j workers (default all cores) take the next run from a      =
+//=            shared index as soon as they finish one, so long runs (high  =
+//=            load) never hold up a worker's share of short ones           =
+//=         3) Runs have stdin on /dev/null (the models' final getchar()    =
+//=            returns at once) and their report is parsed from stdout:     =
+//=            per-server util, qlen, resp, serv, tput, the totals, and     =
+//=            the response time mean with its 95% CI half-width (the       =
+//=            Resp_table run-length CI, or the VR/CV replication CI)       =
+//=         4) Results are written in run order, so the file is the same    =
+//=            for any -j; fields a run did not report are empty (CSV) or   =
+//=            null (JSON), and status is the run's exit code               =
+//=         5) Lists are comma separated or start:stop:step (inclusive),    =
+//=            e.g. -l 0.5:0.95:0.05 -s 1:10                                =
+//=         6) -a accuracy makes the sweep adaptive: each model, load and   =
+//=            delay is a point whose runs are replications over the seeds  =
+//=            (-s, default 1:ADAPT_MAX), and each free worker runs the     =
+//=            next seed of the point whose 95% CI half-width over its run  =
+//=            means is furthest above accuracy x mean (runs in flight      =
+//=            counted as done).  A point stops when it meets the target    =
+//=            or its seeds run out, so all points finish together at one   =
+//=            precision.  Which point gets a run depends on timing, so     =
+//=            the run count (not the seed order) can vary with -j          =
+//=         7) -c dir caches reports: a run's key is the hash of the model  =
+//=            binary (its build: policy, distribution type and stopping    =
+//=            rule), of the input files it reads and of its exact          =
+//=            arguments, and a good report is kept in dir/<hash>.rep with  =
+//=            the key on its first line.  The inputs are EMP_INPUT when it =
+//=            is in the working directory (an EMP build's table, so a new  =
+//=            genalias table is a new key) and any -k files, for whatever  =
+//=            else a model reads.  A cached run is parsed from the file    =
+//=            instead of simulated.  Entries are written to a temporary    =
+//=            file and renamed into place, so any number of workers and    =
+//=            sweeps can share dir                                         =
+//=         8) -p procs (default 1) is passed to every run: a model built   =
+//=            in a replication mode (RUN_REPS, RUN_FORK, VR, CV) would     =
+//=            otherwise start one worker per core, so -j jobs of them      =
+//=            would run about cores^2 processes.  Replication results are  =
+//=            the same for any -p, so it is not part of the cache key;     =
+//=            raise it (and lower -j) for a few long replication runs      =
+//=-------------------------------------------------------------------------=
+//= Example execution:                                                      =
+//=                                                                         =
+//=   sweep -m ./lb_rr,./lb_short -l 0.5:0.9:0.1 -s 1:4 -o curve.csv        =
+//=   ---------------------------------------- sweep.c -------              =
+//=   -  40 runs on 8 workers                                               =
+//=   -  40 of 40 done (0 failed) in 312.4 sec                              =
+//=   -  Results in curve.csv                                               =
+//=   --------------------------------------------------------              =
+//=-------------------------------------------------------------------------=
+//=  Build: gcc -O2 -pthread sweep.c StatsImplementation.c -lm              =
+//=-------------------------------------------------------------------------=
+//=  Execute: sweep -m model[,model...] -l loads [-d delays] [-s seeds]     =
+//=                 [-a accuracy] [-c cachedir] [-k file[,file...]]         =
+//=                 [-j workers] [-p procs] [-f csv|json] [-o file]         =
+//===========================================================================
+//----- Include files -------------------------------------------------------
+#define _GNU_SOURCE           // Needed for pipe2()
+#include <stdio.h>            // Needed for printf()
+#include <stdlib.h>           // Needed for exit(), ato*() and malloc()
+#include <string.h>           // Needed for strtok() and strncmp()
+#include <math.h>             // Needed for NAN and isnan()
+#include <time.h>             // Needed for clock_gettime()
+#include <unistd.h>           // Needed for getopt(), fork() and pipe()
+#include <fcntl.h>            // Needed for open()
+#include <pthread.h>          // Needed for pthread_create()
+#include <sys/wait.h>         // Needed for waitpid()
+#include <sys/stat.h>         // Needed for mkdir()
+#include "StatsInterface.h"   // Needed for stats_half_width()
+
+//----- Constants -----------------------------------------------------------
+#define MAX_LIST    4096      // Most values in one list
+#define MAX_MODELS  16        // Most models
+#define MAX_WORKERS 256       // Most worker threads
+#define NUM_SERVERS 5         // Servers in the models
+#define FMT_CSV     0         // Output formats
+#define FMT_JSON    1
+#define ADAPT_MIN   3         // Runs per point before its CI is trusted
+#define ADAPT_MAX   100       // Seeds per point without -s (adaptive)
+#define MAX_KEY     1024      // Longest cache key
+#define MAX_INPUTS  16        // Most -k input files
+#define EMP_INPUT   "service.emp" // Table an EMP model reads (EMP_FILE)
+
+//----- Types ---------------------------------------------------------------
+typedef struct {
+  double Util;                // Utilization (fraction)
+  double Qlen;                // Mean number in system
+  double Resp;                // Mean response time
+  double Serv;                // Mean service time
+  double Tput;                // Mean throughput
+} SERVER_RESULT;
+
+typedef struct {
+  int    Model;               // Index into Model[]
+  double Load;                // Offered load
+  double Delay;               // Delay (NAN if none)
+  long   Seed;                // Seed (0 if none)
+  int    Status;              // Exit code (-1 if it could not run)
+  double Lambda;              // Parsed from the report
+  double Mu;
+  double Cpu;
+  double SimTime;
+  double Completions;
+  double RespMean;            // Response time mean
+  double RespHalf;            // 95% CI half-width
+  SERVER_RESULT Server[NUM_SERVERS];
+} RUN;
+
+typedef struct {              // Adaptive sweep point
+  int    Model;
+  double Load;
+  double Delay;
+  long   Started;             // Runs handed out (next seed)
+  long   Running;             // Runs in flight
+  STATS  Resp;                // Response time means of good runs
+  int    Finished;            // Target met or seeds used up
+} POINT;
+
+//----- Globals -------------------------------------------------------------
+char     *Model[MAX_MODELS];  // Model binaries
+unsigned long long Build[MAX_MODELS]; // Hash of each binary (0 = unknown)
+int      Num_models = 0;
+char     *Cache_dir = NULL;   // Results cache (-c)
+int      Procs = 1;           // Processes per run (-p)
+char     *Input[MAX_INPUTS];  // Extra input files of the models (-k)
+int      Num_inputs = 0;
+unsigned long long Inputs = 0; // Hash of the input files
+long     Cached = 0;          // Runs taken from the cache
+RUN      *Run;                // Every run, in output order
+long     Num_runs;
+long     Next_run = 0;        // Next run to take
+long     Done = 0;            // Runs finished
+long     Failed = 0;          // Runs with nonzero status
+pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+double   Accuracy = 0.0;      // Relative CI target (0 = not adaptive)
+POINT    *Point;              // Adaptive points; runs of point p are
+long     Num_points;          //   Run[p * Per_point + k], k < Started
+long     Per_point;           // Seeds per point
+double   *Seed_list;          // Seeds in order (adaptive)
+long     In_flight = 0;       // Runs in flight (adaptive)
+pthread_cond_t Wake = PTHREAD_COND_INITIALIZER;
+
+//----- Function prototypes -------------------------------------------------
+void   usage(void);                           // Print the option summary
+int    parse_list(char *arg, double *v);      // Comma list or range
+void   *worker(void *arg);                    // Take runs until none left
+void   *adapt_worker(void *arg);              // Take the neediest point's run
+long   next_adaptive(void);                   // Pick it (Lock held)
+void   compact_runs(void);                    // Drop unused adaptive slots
+unsigned long long fnv1a(unsigned long long h, const void *p, size_t n);
+unsigned long long file_hash(const char *name); // Hash of a file (0 if none)
+unsigned long long input_hash(void);           // Hash of the input files
+char   *cache_get(const char *key, unsigned long long h); // Cached report
+void   cache_put(const char *key, unsigned long long h, const char *text,
+                 size_t len);                 // Keep a good report
+void   do_run(RUN *r);                        // Run one model and parse it
+void   parse_report(char *text, RUN *r);      // Fill r from a report
+void   put_num(FILE *fp, double x, int fmt);  // Number, or empty/null
+void   write_csv(FILE *fp);
+void   write_json(FILE *fp);
+
+//===== Main program ========================================================
+int main(int argc, char *argv[])
+{
+  double    load[MAX_LIST];   // Offered loads
+  double    delay[MAX_LIST];  // Delays
+  double    seed[MAX_LIST];   // Seeds
+  int       num_load = 0;
+  int       num_delay = 0;
+  int       num_seed = 0;
+  int       workers;          // Worker threads
+  int       format = FMT_CSV; // Output format
+  char      *out_name = NULL; // Output file (stdout if none)
+  char      *tok;             // Model name
+  FILE      *fp;              // Output file
+  pthread_t tid[MAX_WORKERS]; // Worker threads
+  struct timespec t0, t1;     // Start and end times
+  long      n;                // Run index
+  int       m, i, j, k;       // Loop counters
+  int       c;                // Option character
+
+  workers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  while ((c = getopt(argc, argv, "m:l:d:s:a:c:k:j:p:f:o:")) != -1)
+  {
+    switch (c)
+    {
+      case 'm':
+        for (tok = strtok(optarg, ","); tok != NULL; tok = strtok(NULL, ","))
+        {
+          if (Num_models == MAX_MODELS)
+            usage();
+          Model[Num_models++] = tok;
+        }
+        break;
+      case 'l': num_load = parse_list(optarg, load); break;
+      case 'd': num_delay = parse_list(optarg, delay); break;
+      case 's': num_seed = parse_list(optarg, seed); break;
+      case 'a': Accuracy = atof(optarg); if (Accuracy <= 0.0) usage(); break;
+      case 'c': Cache_dir = optarg; break;
+      case 'k':
+        for (tok = strtok(optarg, ","); tok != NULL; tok = strtok(NULL, ","))
+        {
+          if (Num_inputs == MAX_INPUTS)
+            usage();
+          Input[Num_inputs++] = tok;
+        }
+        break;
+      case 'j': workers = atoi(optarg); break;
+      case 'p': Procs = atoi(optarg); if (Procs < 1) usage(); break;
+      case 'f':
+        if (strcmp(optarg, "csv") == 0) format = FMT_CSV;
+        else if (strcmp(optarg, "json") == 0) format = FMT_JSON;
+        else usage();
+        break;
+      case 'o': out_name = optarg; break;
+      default: usage();
+    }
+  }
+  if ((Num_models == 0) || (num_load <= 0) || (num_delay < 0) ||
+      (num_seed < 0) || (workers < 1))
+    usage();
+  if (workers > MAX_WORKERS)
+    workers = MAX_WORKERS;
+  if (Cache_dir != NULL)
+  {
+    mkdir(Cache_dir, 0755);
+    for (m=0; m<Num_models; m++)
+      Build[m] = file_hash(Model[m]);
+    Inputs = input_hash();
+  }
+
+  // One run per combination; an empty delay or seed list means none.
+  // Adaptive: room for every seed of every point, filled as needed
+  Num_points = (long) Num_models * num_load * (num_delay ? num_delay : 1);
+  Per_point = (Accuracy > 0.0) ? (num_seed ? num_seed : ADAPT_MAX) :
+                                 (num_seed ? num_seed : 1);
+  Num_runs = Num_points * Per_point;
+  Run = (RUN *) calloc(Num_runs, sizeof(RUN));
+  Point = (POINT *) calloc(Num_points, sizeof(POINT));
+  Seed_list = (double *) malloc(Per_point * sizeof(double));
+  if ((Run == NULL) || (Point == NULL) || (Seed_list == NULL))
+  {
+    printf("ERROR in allocating %ld runs \n", Num_runs);
+    exit(1);
+  }
+  for (n=0; n<Per_point; n++)
+    Seed_list[n] = num_seed ? seed[n] : n + 1;
+  n = 0;
+  for (m=0; m<Num_models; m++)
+    for (i=0; i<num_load; i++)
+      for (j=0; j<(num_delay ? num_delay : 1); j++)
+      {
+        Point[n / Per_point].Model = m;
+        Point[n / Per_point].Load = load[i];
+        Point[n / Per_point].Delay = num_delay ? delay[j] : NAN;
+        stats_reset(&Point[n / Per_point].Resp);
+        for (k=0; k<Per_point; k++)
+        {
+          Run[n].Model = m;
+          Run[n].Load = load[i];
+          Run[n].Delay = num_delay ? delay[j] : NAN;
+          Run[n].Seed = ((Accuracy > 0.0) || num_seed) ? (long) Seed_list[k] : 0;
+          n++;
+        }
+      }
+  if ((Accuracy == 0.0) && (workers > Num_runs))
+    workers = (int) Num_runs;
+
+  fprintf(stderr, "---------------------------------------- sweep.c ------- \n");
+  if (Accuracy > 0.0)
+    fprintf(stderr, "-  %ld points to a %g relative CI (at most %ld runs each) "
+      "on %d workers \n", Num_points, Accuracy, Per_point, workers);
+  else
+    fprintf(stderr, "-  %ld runs on %d workers \n", Num_runs, workers);
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (i=0; i<workers; i++)
+  {
+    if (pthread_create(&tid[i], NULL,
+                       (Accuracy > 0.0) ? adapt_worker : worker, NULL) != 0)
+    {
+      fprintf(stderr, "ERROR in starting worker %d \n", i);
+      exit(1);
+    }
+  }
+  for (i=0; i<workers; i++)
+    pthread_join(tid[i], NULL);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  if (Accuracy > 0.0)
+  {
+    fprintf(stderr, "\r-  %ld runs done (%ld failed) in %.1f sec \n",
+      Done, Failed,
+      (t1.tv_sec - t0.tv_sec) + 1.0e-9 * (t1.tv_nsec - t0.tv_nsec));
+    for (n=0; n<Num_points; n++)
+    {
+      fprintf(stderr, "-  %s %.10g", Model[Point[n].Model], Point[n].Load);
+      if (!isnan(Point[n].Delay))
+        fprintf(stderr, " %.10g", Point[n].Delay);
+      fprintf(stderr, ": %ld runs, %f +/- %f \n", Point[n].Resp.N,
+        stats_mean(&Point[n].Resp), stats_half_width(&Point[n].Resp, 0.95));
+    }
+    compact_runs();
+  }
+  else
+    fprintf(stderr, "\r-  %ld of %ld done (%ld failed) in %.1f sec \n",
+      Done, Num_runs, Failed,
+      (t1.tv_sec - t0.tv_sec) + 1.0e-9 * (t1.tv_nsec - t0.tv_nsec));
+
+  // Write the results in run order
+  fp = (out_name == NULL) ? stdout : fopen(out_name, "w");
+  if (fp == NULL)
+  {
+    fprintf(stderr, "ERROR in opening output file %s \n", out_name);
+    exit(1);
+  }
+  if (format == FMT_CSV)
+    write_csv(fp);
+  else
+    write_json(fp);
+  if ((fp != stdout) && (fclose(fp) != 0))
+  {
+    fprintf(stderr, "ERROR in writing output file %s \n", out_name);
+    exit(1);
+  }
+  if (Cache_dir != NULL)
+    fprintf(stderr, "-  %ld runs from the cache in %s \n", Cached, Cache_dir);
+  if (out_name != NULL)
+    fprintf(stderr, "-  Results in %s \n", out_name);
+  fprintf(stderr, "-------------------------------------------------------- \n");
+
+  free(Run);
+  free(Point);
+  free(Seed_list);
+  return(Failed != 0);
+}
+
+//===========================================================================
+//=  Function to print the option summary and exit                          =
+//===========================================================================
+void usage(void)
+{
+  fprintf(stderr, "Usage: sweep -m model[,model...] -l loads [-d delays] \n");
+  fprintf(stderr, "             [-s seeds] [-a accuracy] [-c cachedir] \n");
+  fprintf(stderr, "             [-k file[,file...]] \n");
+  fprintf(stderr, "             [-j workers] [-p procs] [-f csv|json] \n");
+  fprintf(stderr, "             [-o file] \n");
+  fprintf(stderr, "       lists are a,b,c or start:stop:step \n");
+  exit(1);
+}
+
+//===========================================================================
+//=  Function to parse a comma list or start:stop[:step] range into v       =
+//=    - Returns the number of values, or -1 on a bad list                  =
+//===========================================================================
+int parse_list(char *arg, double *v)
+{
+  double start, stop;         // Range ends
+  double step = 1.0;          // Range step
+  char   *tok;                // List item
+  int    n = 0;               // Values parsed
+
+  if (strchr(arg, ':') != NULL)
+  {
+    if ((sscanf(arg, "%lf:%lf:%lf", &start, &stop, &step) < 2) ||
+        (step <= 0.0) || (stop < start))
+      return -1;
+    // Half a step of slack keeps the end point despite rounding
+    for (n=0; (n < MAX_LIST) && (start + n * step <= stop + 0.5 * step); n++)
+      v[n] = start + n * step;
+    return n;
+  }
+
+  for (tok = strtok(arg, ","); tok != NULL; tok = strtok(NULL, ","))
+  {
+    if (n == MAX_LIST)
+      return -1;
+    v[n++] = atof(tok);
+  }
+  return n;
+}
+
+//===========================================================================
+//=  Function for a worker thread: take the next run until none are left    =
+//===========================================================================
+void *worker(void *arg)
+{
+  long n;                     // Run taken
+
+  (void) arg;
+  while (1)
+  {
+    pthread_mutex_lock(&Lock);
+    n = Next_run++;
+    pthread_mutex_unlock(&Lock);
+    if (n >= Num_runs)
+      break;
+
+    do_run(&Run[n]);
+
+    pthread_mutex_lock(&Lock);
+    Done++;
+    if (Run[n].Status != 0)
+      Failed++;
+    fprintf(stderr, "\r-  %ld of %ld done ", Done, Num_runs);
+    pthread_mutex_unlock(&Lock);
+  }
+  return NULL;
+}
+
+//===========================================================================
+//=  Function for an adaptive worker: run the neediest point's next seed    =
+//=  until every point has finished                                         =
+//===========================================================================
+void *adapt_worker(void *arg)
+{
+  POINT *p;                   // Point of the run
+  long  n;                    // Run taken
+  double x;                   // Its response time mean
+
+  (void) arg;
+  pthread_mutex_lock(&Lock);
+  while (1)
+  {
+    // Nothing to start yet: wait for a run in flight to change the CIs
+    while (((n = next_adaptive()) < 0) && (In_flight > 0))
+      pthread_cond_wait(&Wake, &Lock);
+    if (n < 0)
+      break;
+    p = &Point[n / Per_point];
+    p->Started++;
+    p->Running++;
+    In_flight++;
+    pthread_mutex_unlock(&Lock);
+
+    do_run(&Run[n]);
+
+    pthread_mutex_lock(&Lock);
+    x = Run[n].RespMean;
+    if ((Run[n].Status == 0) && !isnan(x))
+      stats_add(&p->Resp, x);
+    else
+      Failed++;
+    p->Running--;
+    In_flight--;
+    Done++;
+    fprintf(stderr, "\r-  %ld runs done ", Done);
+    pthread_cond_broadcast(&Wake);
+  }
+  pthread_mutex_unlock(&Lock);
+  return NULL;
+}
+
+//===========================================================================
+//=  Function to pick the next adaptive run (called with Lock held)         =
+//=    - Points with fewer than ADAPT_MIN good or running runs come first   =
+//=    - Otherwise the largest half-width / (Accuracy x mean), scaled by    =
+//=      sqrt(N / (N + running)) for the runs still to come in; a point     =
+//=      projected at or under 1 waits for them                             =
+//=    - Returns the run index, or -1 if no point can take a run now        =
+//===========================================================================
+long next_adaptive(void)
+{
+  POINT  *p;                  // Current point
+  double ratio;               // Projected half-width over target
+  double best = 0.0;          // Largest so far
+  long   pick = -1;           // Its point
+  long   n;                   // Point index
+
+  for (n=0; n<Num_points; n++)
+  {
+    p = &Point[n];
+    if (p->Finished)
+      continue;
+    if (p->Started == Per_point)
+    {
+      p->Finished = (p->Running == 0);
+      continue;
+    }
+    if (p->Resp.N + p->Running < ADAPT_MIN)
+      ratio = HUGE_VAL;
+    else if (p->Resp.N < ADAPT_MIN)
+      continue;
+    else
+    {
+      ratio = stats_half_width(&p->Resp, 0.95) /
+              (Accuracy * fabs(stats_mean(&p->Resp)));
+      if ((ratio <= 1.0) && (p->Running == 0))
+      {
+        p->Finished = 1;
+        continue;
+      }
+      ratio *= sqrt((double) p->Resp.N / (p->Resp.N + p->Running));
+      if (ratio <= 1.0)
+        continue;
+    }
+    // Ties (e.g. every point still filling) go to the fewest started
+    if ((pick < 0) || (ratio > best) ||
+        ((ratio == best) && (p->Started < Point[pick].Started)))
+    {
+      best = ratio;
+      pick = n;
+    }
+  }
+  if (pick < 0)
+    return -1;
+  return pick * Per_point + Point[pick].Started;
+}
+
+//===========================================================================
+//=  Function to move the adaptive runs that ran to the front, in point     =
+//=  and seed order                                                         =
+//===========================================================================
+void compact_runs(void)
+{
+  long   n = 0;               // Runs kept
+  long   p, k;                // Point and seed
+
+  for (p=0; p<Num_points; p++)
+    for (k=0; k<Point[p].Started; k++)
+      Run[n++] = Run[p * Per_point + k];
+  Num_runs = n;
+}
+
+//===========================================================================
+//=  Function to run one model with stdout on a pipe and parse its report   =
+//===========================================================================
+void do_run(RUN *r)
+{
+  char   load_arg[32];        // Arguments as text
+  char   delay_arg[32];
+  char   seed_arg[32];
+  char   procs_arg[32];
+  char   *argv[8];            // Model arguments
+  char   key[MAX_KEY];        // Cache key: build and arguments
+  unsigned long long h = 0;   // Its hash (0 = not cached)
+  char   *text = NULL;        // Report text
+  size_t len = 0;             // Report length
+  size_t cap = 0;             // Report buffer size
+  ssize_t got;                // Bytes read
+  int    fd[2];               // Pipe from the model
+  int    devnull;             // stdin for the model
+  int    status;              // Wait status
+  int    a = 0;               // Arguments so far
+  pid_t  pid;                 // Model process
+
+  r->Status = -1;
+  r->Lambda = r->Mu = r->Cpu = r->SimTime = r->Completions = NAN;
+  r->RespMean = r->RespHalf = NAN;
+  for (a=0; a<NUM_SERVERS; a++)
+  {
+    r->Server[a].Util = r->Server[a].Qlen = r->Server[a].Resp = NAN;
+    r->Server[a].Serv = r->Server[a].Tput = NAN;
+  }
+
+  a = 0;
+  argv[a++] = Model[r->Model];
+  snprintf(procs_arg, sizeof(procs_arg), "%d", Procs);
+  argv[a++] = "-p";
+  argv[a++] = procs_arg;
+  if (r->Seed != 0)
+  {
+    snprintf(seed_arg, sizeof(seed_arg), "%ld", r->Seed);
+    argv[a++] = "-s";
+    argv[a++] = seed_arg;
+  }
+  snprintf(load_arg, sizeof(load_arg), "%.10g", r->Load);
+  argv[a++] = load_arg;
+  if (!isnan(r->Delay))
+  {
+    snprintf(delay_arg, sizeof(delay_arg), "%.10g", r->Delay);
+    argv[a++] = delay_arg;
+  }
+  argv[a] = NULL;
+
+  // A report of the same build, inputs and arguments is as good as a new run
+  if ((Cache_dir != NULL) && (Build[r->Model] != 0))
+  {
+    len = snprintf(key, sizeof(key), "%016llx %016llx", Build[r->Model],
+                   Inputs);
+    for (a=3; (argv[a] != NULL) && (len < sizeof(key)); a++) // Not -p
+      len += snprintf(key + len, sizeof(key) - len, " %s", argv[a]);
+    h = fnv1a(0, key, strlen(key));
+    len = 0;
+    text = cache_get(key, h);
+    if (text != NULL)
+    {
+      r->Status = 0;
+      parse_report(text, r);
+      free(text);
+      pthread_mutex_lock(&Lock);
+      Cached++;
+      pthread_mutex_unlock(&Lock);
+      return;
+    }
+  }
+
+  // Close-on-exec, so runs forked by other workers do not hold this pipe
+  // open and delay its end of file
+  if (pipe2(fd, O_CLOEXEC) != 0)
+    return;
+  pid = fork();
+  if (pid < 0)
+  {
+    close(fd[0]);
+    close(fd[1]);
+    return;
+  }
+  if (pid == 0)
+  {
+    devnull = open("/dev/null", O_RDONLY);
+    if (devnull >= 0)
+      dup2(devnull, 0);
+    dup2(fd[1], 1);
+    close(fd[0]);
+    close(fd[1]);
+    execv(argv[0], argv);
+    _exit(127);
+  }
+  close(fd[1]);
+
+  // Read the whole report; the model may block until the pipe drains
+  while (1)
+  {
+    if (len + 4096 + 1 > cap)
+    {
+      cap = (cap == 0) ? 65536 : 2 * cap;
+      text = (char *) realloc(text, cap);
+      if (text == NULL)
+      {
+        fprintf(stderr, "ERROR out of memory for a report \n");
+        exit(1);
+      }
+    }
+    got = read(fd[0], text + len, cap - len - 1);
+    if (got <= 0)
+      break;
+    len += got;
+  }
+  close(fd[0]);
+  while ((waitpid(pid, &status, 0) < 0))
+    ;
+
+  if (WIFEXITED(status))
+    r->Status = WEXITSTATUS(status);
+  else
+    r->Status = 128 + WTERMSIG(status);
+  if (text != NULL)
+  {
+    text[len] = '\0';
+    if ((h != 0) && (r->Status == 0))
+      cache_put(key, h, text, len);
+    parse_report(text, r);
+    free(text);
+  }
+}
+
+//===========================================================================
+//=  Function to extend a 64-bit FNV-1a hash h (0 to start) over n bytes    =
+//===========================================================================
+unsigned long long fnv1a(unsigned long long h, const void *p, size_t n)
+{
+  const unsigned char *c = (const unsigned char *) p;
+  size_t i;                   // Byte index
+
+  if (h == 0)
+    h = 14695981039346656037ULL;
+  for (i=0; i<n; i++)
+  {
+    h ^= c[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+//===========================================================================
+//=  Function to hash a model binary, which identifies its build            =
+//===========================================================================
+unsigned long long file_hash(const char *name)
+{
+  unsigned char buf[65536];   // File contents
+  unsigned long long h = 0;   // Hash so far
+  size_t n;                   // Bytes read
+  FILE   *fp;                 // The binary
+
+  fp = fopen(name, "rb");
+  if (fp == NULL)
+    return 0;
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    h = fnv1a(h, buf, n);
+  fclose(fp);
+  return h;
+}
+
+//===========================================================================
+//=//=  Function to hash the models' input files: EMP_INPUT if it is there  =
+//=//=  and every -k file (a missing -k file is an error)                   =
+//===========================================================================
+unsigned long long input_hash(void)
+{
+  unsigned long long h = 0;   // Hash so far
+  unsigned long long f;       // Hash of one file
+  int    i;
+
+  if (access(EMP_INPUT, R_OK) == 0)
+  {
+    f = file_hash(EMP_INPUT);
+    h = fnv1a(h, EMP_INPUT, strlen(EMP_INPUT));
+    h = fnv1a(h, &f, sizeof(f));
+  }
+  for (i=0; i<Num_inputs; i++)
+  {
+    if (access(Input[i], R_OK) != 0)
+    {
+      fprintf(stderr, "ERROR cannot read input file %s \n", Input[i]);
+      exit(1);
+    }
+    f = file_hash(Input[i]);
+    h = fnv1a(h, Input[i], strlen(Input[i]));
+    h = fnv1a(h, &f, sizeof(f));
+  }
+  return h;
+}
+
+//===========================================================================
+//=  Function to read a cached report: NULL if there is none or its first   =
+//=  line is another key (a hash collision)                                 =
+//===========================================================================
+char *cache_get(const char *key, unsigned long long h)
+{
+  char   path[4096];          // Entry file
+  char   *text;               // Entry contents
+  long   size;                // Entry size
+  size_t klen = strlen(key);  // Key length
+  FILE   *fp;                 // Entry
+
+  snprintf(path, sizeof(path), "%s/%016llx.rep", Cache_dir, h);
+  fp = fopen(path, "rb");
+  if (fp == NULL)
+    return NULL;
+  fseek(fp, 0, SEEK_END);
+  size = ftell(fp);
+  rewind(fp);
+  text = (size > (long) klen) ? (char *) malloc(size + 1) : NULL;
+  if ((text == NULL) || (fread(text, 1, size, fp) != (size_t) size) ||
+      (memcmp(text, key, klen) != 0) || (text[klen] != '\n'))
+  {
+    free(text);
+    fclose(fp);
+    return NULL;
+  }
+  fclose(fp);
+  text[size] = '\0';
+  memmove(text, text + klen + 1, size - klen);
+  return text;
+}
+
+//===========================================================================
+//=  Function to add a report to the cache: written under a name of its     =
+//=  own, then renamed, so readers only ever see whole entries              =
+//===========================================================================
+void cache_put(const char *key, unsigned long long h, const char *text,
+               size_t len)
+{
+  char   path[4096];          // Entry file
+  char   tmp[4200];           // Temporary file
+  FILE   *fp;                 // Entry
+  int    ok;                  // Written in full
+
+  snprintf(path, sizeof(path), "%s/%016llx.rep", Cache_dir, h);
+  snprintf(tmp, sizeof(tmp), "%s.%ld.%lx.tmp", path, (long) getpid(),
+    (unsigned long) pthread_self());
+  fp = fopen(tmp, "wb");
+  if (fp == NULL)
+    return;
+  ok = (fprintf(fp, "%s\n", key) > 0) && (fwrite(text, 1, len, fp) == len);
+  ok = (fclose(fp) == 0) && ok;
+  if (!ok || (rename(tmp, path) != 0))
+    unlink(tmp);
+}
+
+//===========================================================================
+//=  Function to pick the numbers out of a model report                     =
+//=    - The replication (VR/CV) report prints its mean and CI last, so     =
+//=      the last "& Mean response time" line is the headline estimate      =
+//===========================================================================
+void parse_report(char *text, RUN *r)
+{
+  char   *line;               // Current line
+  char   *save;               // strtok_r state
+  double v, w;                // Parsed values
+  int    k;                   // Server number
+
+  for (line = strtok_r(text, "\n", &save); line != NULL;
+       line = strtok_r(NULL, "\n", &save))
+  {
+    if (sscanf(line, "= Utilization %d = %lf", &k, &v) == 2)
+    {
+      if ((k >= 1) && (k <= NUM_SERVERS)) r->Server[k - 1].Util = v / 100.0;
+    }
+    else if (sscanf(line, "= Mean num in system %d = %lf", &k, &v) == 2)
+    {
+      if ((k >= 1) && (k <= NUM_SERVERS)) r->Server[k - 1].Qlen = v;
+    }
+    else if (sscanf(line, "= Mean response time %d = %lf", &k, &v) == 2)
+    {
+      if ((k >= 1) && (k <= NUM_SERVERS)) r->Server[k - 1].Resp = v;
+    }
+    else if (sscanf(line, "= Mean service time %d = %lf", &k, &v) == 2)
+    {
+      if ((k >= 1) && (k <= NUM_SERVERS)) r->Server[k - 1].Serv = v;
+    }
+    else if (sscanf(line, "= Mean throughput %d = %lf", &k, &v) == 2)
+    {
+      if ((k >= 1) && (k <= NUM_SERVERS)) r->Server[k - 1].Tput = v;
+    }
+    else if (sscanf(line, "= Lambda = %lf", &v) == 1)
+      r->Lambda = v;
+    else if (sscanf(line, "= Mu (for each server) = %lf", &v) == 1)
+      r->Mu = v;
+    else if (sscanf(line, "= Total CPU time = %lf", &v) == 1)
+      r->Cpu = v;
+    else if (sscanf(line, "= Total sim time = %lf", &v) == 1)
+      r->SimTime = v;
+    else if (sscanf(line, "= Total completions = %lf", &v) == 1)
+      r->Completions = v;
+    else if (sscanf(line, "& Table mean for response time = %lf", &v) == 1)
+      r->RespMean = v;
+    else if (sscanf(line, "& Mean response time = %lf", &v) == 1)
+      r->RespMean = v;
+    else if (sscanf(line, "& 95%% CI half-width = %lf", &v) == 1)
+      r->RespHalf = v;
+    else if (sscanf(line, " %lf%% confidence interval: %lf +/- %lf",
+                    &w, &v, &w) == 3)
+      r->RespHalf = w;
+  }
+}
+
+//===========================================================================
+//=  Functions to write the results                                         =
+//===========================================================================
+void put_num(FILE *fp, double x, int fmt)
+{
+  if (isnan(x))
+  {
+    if (fmt == FMT_JSON)
+      fprintf(fp, "null");
+  }
+  else
+    fprintf(fp, "%.10g", x);
+}
+
+void write_csv(FILE *fp)
+{
+  RUN    *r;                  // Current run
+  long   n;                   // Run index
+  int    k;                   // Server index
+
+  fprintf(fp, "model,load,delay,seed,status,lambda,mu,cpu,sim_time,"
+              "completions,resp_mean,resp_ci95");
+  for (k=1; k<=NUM_SERVERS; k++)
+    fprintf(fp, ",util%d,qlen%d,resp%d,serv%d,tput%d", k, k, k, k, k);
+  fprintf(fp, "\n");
+
+  for (n=0; n<Num_runs; n++)
+  {
+    r = &Run[n];
+    fprintf(fp, "%s,%.10g,", Model[r->Model], r->Load);
+    put_num(fp, r->Delay, FMT_CSV);
+    fprintf(fp, ",");
+    if (r->Seed != 0)
+      fprintf(fp, "%ld", r->Seed);
+    fprintf(fp, ",%d", r->Status);
+    fprintf(fp, ",");  put_num(fp, r->Lambda, FMT_CSV);
+    fprintf(fp, ",");  put_num(fp, r->Mu, FMT_CSV);
+    fprintf(fp, ",");  put_num(fp, r->Cpu, FMT_CSV);
+    fprintf(fp, ",");  put_num(fp, r->SimTime, FMT_CSV);
+    fprintf(fp, ",");  put_num(fp, r->Completions, FMT_CSV);
+    fprintf(fp, ",");  put_num(fp, r->RespMean, FMT_CSV);
+    fprintf(fp, ",");  put_num(fp, r->RespHalf, FMT_CSV);
+    for (k=0; k<NUM_SERVERS; k++)
+    {
+      fprintf(fp, ",");  put_num(fp, r->Server[k].Util, FMT_CSV);
+      fprintf(fp, ",");  put_num(fp, r->Server[k].Qlen, FMT_CSV);
+      fprintf(fp, ",");  put_num(fp, r->Server[k].Resp, FMT_CSV);
+      fprintf(fp, ",");  put_num(fp, r->Server[k].Serv, FMT_CSV);
+      fprintf(fp, ",");  put_num(fp, r->Server[k].Tput, FMT_CSV);
+    }
+    fprintf(fp, "\n");
+  }
+}
+
+void write_json(FILE *fp)
+{
+  RUN    *r;                  // Current run
+  const char *c;              // Model name character
+  long   n;                   // Run index
+  int    k;                   // Server index
+
+  fprintf(fp, "[\n");
+  for (n=0; n<Num_runs; n++)
+  {
+    r = &Run[n];
+    fprintf(fp, "  {\"model\": \"");
+    for (c = Model[r->Model]; *c != '\0'; c++)
+    {
+      if ((*c == '"') || (*c == '\\'))
+        fputc('\\', fp);
+      fputc(*c, fp);
+    }
+    fprintf(fp, "\", \"load\": %.10g, \"delay\": ", r->Load);
+    put_num(fp, r->Delay, FMT_JSON);
+    fprintf(fp, ", \"seed\": ");
+    if (r->Seed != 0)
+      fprintf(fp, "%ld", r->Seed);
+    else
+      fprintf(fp, "null");
+    fprintf(fp, ", \"status\": %d,\n   \"lambda\": ", r->Status);
+    put_num(fp, r->Lambda, FMT_JSON);
+    fprintf(fp, ", \"mu\": ");           put_num(fp, r->Mu, FMT_JSON);
+    fprintf(fp, ", \"cpu\": ");          put_num(fp, r->Cpu, FMT_JSON);
+    fprintf(fp, ", \"sim_time\": ");     put_num(fp, r->SimTime, FMT_JSON);
+    fprintf(fp, ", \"completions\": ");  put_num(fp, r->Completions, FMT_JSON);
+    fprintf(fp, ",\n   \"resp_mean\": ");
+    put_num(fp, r->RespMean, FMT_JSON);
+    fprintf(fp, ", \"resp_ci95\": ");    put_num(fp, r->RespHalf, FMT_JSON);
+    fprintf(fp, ",\n   \"servers\": [");
+    for (k=0; k<NUM_SERVERS; k++)
+    {
+      fprintf(fp, "%s\n     {\"util\": ", (k == 0) ? "" : ",");
+      put_num(fp, r->Server[k].Util, FMT_JSON);
+      fprintf(fp, ", \"qlen\": ");  put_num(fp, r->Server[k].Qlen, FMT_JSON);
+      fprintf(fp, ", \"resp\": ");  put_num(fp, r->Server[k].Resp, FMT_JSON);
+      fprintf(fp, ", \"serv\": ");  put_num(fp, r->Server[k].Serv, FMT_JSON);
+      fprintf(fp, ", \"tput\": ");  put_num(fp, r->Server[k].Tput, FMT_JSON);
+      fprintf(fp, "}");
+    }
+    fprintf(fp, "]}%s\n", (n == Num_runs - 1) ? "" : ",");
+  }
+  fprintf(fp, "]\n");
+}